@@ -1,7 +1,7 @@
 #!/bin/bash
 # build.sh - Compile NERD CMS to WebAssembly for Cloudflare Workers
 #
-# Usage: ./build.sh [nerd_file]
+# Usage: [ASYNCIFY=1] ./build.sh [nerd_file]
 # Default: cms.nerd
 
 set -e
@@ -9,31 +9,45 @@ set -e
 NERD_FILE="${1:-cms.nerd}"
 BASENAME="${NERD_FILE%.nerd}"
 LLVM_BIN="/opt/homebrew/opt/llvm/bin"
+# SIMD128 string kernels and memory.copy/memory.fill for bulk copies
+WASM_FEATURES="-msimd128 -mbulk-memory"
 
 echo "=== NERD CMS Build Pipeline ==="
-echo "[1/4] Compiling NERD -> LLVM IR"
+echo "[0/6] Compiling routes.json -> routes_gen.h, src/routes_gen.js"
+node tools/gen_routes.mjs routes.json
+
+echo "[1/6] Compiling NERD -> LLVM IR"
 ./nerd-darwin-arm64/nerd compile "$NERD_FILE" -o "${BASENAME}.ll"
 
 # Step 1.5: Inject missing declarations and target info
-echo "[1.5/4] Injecting target info and external declarations"
+echo "[1.5/6] Injecting target info and external declarations"
 # Insert at the top of the file
 sed -i '' '1i\
 target datalayout = "e-m:e-p:32:32-p10:8:8-p20:8:8-i64:64-i128:128-n32:64-S128-ni:1:10:20"\
 target triple = "wasm32-unknown-unknown"\
 declare double @print_buffer()\
 declare double @wasm_get_shared_buffer()\
+declare double @wasm_arena_push()\
+declare double @wasm_arena_pop()\
+declare double @print_post_list()\
+declare double @print_rss_items()\
+declare double @print_blog_list()\
+declare double @print_query_q()\
+declare double @print_sort_tabs()\
+declare double @print_post_header()\
+declare double @print_post_body()\
 ' "${BASENAME}.ll"
 
 # Step 2: Compile LLVM IR to Wasm object
-echo "[2/4] Compiling LLVM IR -> Wasm object"
-$LLVM_BIN/clang --target=wasm32-unknown-unknown -O2 -c "${BASENAME}.ll" -o "${BASENAME}.o"
+echo "[2/6] Compiling LLVM IR -> Wasm object"
+$LLVM_BIN/clang --target=wasm32-unknown-unknown -O2 $WASM_FEATURES -c "${BASENAME}.ll" -o "${BASENAME}.o"
 
 # Step 3: Compile runtime to Wasm object
-echo "[3/4] Compiling runtime -> Wasm object"
-$LLVM_BIN/clang --target=wasm32-unknown-unknown -O2 -c runtime_wasm.c -o runtime_wasm.o
+echo "[3/6] Compiling runtime -> Wasm object"
+$LLVM_BIN/clang --target=wasm32-unknown-unknown -O2 $WASM_FEATURES -c runtime_wasm.c -o runtime_wasm.o
 
 # Step 4: Link into final Wasm module
-echo "[4/4] Linking -> ${BASENAME}.wasm"
+echo "[4/6] Linking -> ${BASENAME}.wasm"
 wasm-ld \
     --no-entry \
     --export-all \
@@ -44,6 +58,23 @@ wasm-ld \
     "${BASENAME}.o" \
     runtime_wasm.o
 
+# Step 5: Async host calls (js_http_fetch, js_kv_get, js_load_posts) suspend
+# the render through JS Promise Integration where the runtime has it. ASYNCIFY=1
+# builds the fallback instead: tools/asyncify.sh instruments the call paths
+# that can reach those imports, and the worker drives unwind/rewind itself (it
+# detects the asyncify_* exports).
+if [ "${ASYNCIFY:-0}" = "1" ]; then
+    echo "[5/6] Asyncify -> ${BASENAME}.wasm"
+    tools/asyncify.sh "${BASENAME}.wasm"
+else
+    echo "[5/6] Asyncify skipped (JSPI build; ASYNCIFY=1 for the fallback)"
+fi
+
+# Step 6: Run wasm_init once and bake the resulting memory into data segments,
+# so fresh instances start with the isolate tables already built
+echo "[6/6] Pre-initializing -> ${BASENAME}.wasm (memory snapshot)"
+node tools/wizer.mjs "${BASENAME}.wasm" --init-func wasm_init
+
 echo "=== Build Complete ==="
 echo "Output: ${BASENAME}.wasm"
 ls -lh "${BASENAME}.wasm"
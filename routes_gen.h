@@ -0,0 +1,241 @@
+// routes_gen.h - generated by tools/gen_routes.mjs from routes.json. Do not edit.
+
+enum route_id {
+    ROUTE_NONE,
+    ROUTE_API_POSTS,
+    ROUTE_API_POST,
+    ROUTE_API_POST_SAVE,
+    ROUTE_API_POST_DELETE,
+    ROUTE_HOME,
+    ROUTE_ABOUT,
+    ROUTE_BLOG,
+    ROUTE_POST,
+    ROUTE_TG_WEBHOOK,
+    ROUTE_ADMIN_SAVE,
+    ROUTE_ADMIN_GENERATE,
+    ROUTE_ADMIN,
+    ROUTE_RSS,
+    ROUTE_FEED,
+    ROUTE_MCP,
+    ROUTE_RAG,
+    ROUTE_SUBSCRIBE,
+    ROUTE_SUBSCRIBERS,
+    ROUTE_METRICS,
+    ROUTE_PLUGINS,
+    ROUTE_RAW,
+    ROUTE_COUNT
+};
+
+enum route_method {
+    ROUTE_METHOD_ANY,
+    ROUTE_METHOD_GET,
+    ROUTE_METHOD_POST,
+    ROUTE_METHOD_DELETE,
+    ROUTE_METHOD_COUNT
+};
+
+static const char* const route_method_names[ROUTE_METHOD_COUNT] = {
+    0,
+    "GET",
+    "POST",
+    "DELETE",
+};
+
+static const unsigned char route_methods[ROUTE_COUNT] = {
+    ROUTE_METHOD_ANY,
+    ROUTE_METHOD_GET,
+    ROUTE_METHOD_GET,
+    ROUTE_METHOD_POST,
+    ROUTE_METHOD_DELETE,
+    ROUTE_METHOD_ANY,
+    ROUTE_METHOD_ANY,
+    ROUTE_METHOD_ANY,
+    ROUTE_METHOD_ANY,
+    ROUTE_METHOD_POST,
+    ROUTE_METHOD_POST,
+    ROUTE_METHOD_POST,
+    ROUTE_METHOD_ANY,
+    ROUTE_METHOD_ANY,
+    ROUTE_METHOD_ANY,
+    ROUTE_METHOD_POST,
+    ROUTE_METHOD_ANY,
+    ROUTE_METHOD_POST,
+    ROUTE_METHOD_ANY,
+    ROUTE_METHOD_GET,
+    ROUTE_METHOD_ANY,
+    ROUTE_METHOD_ANY,
+};
+
+// Renderers that need no host data; weak, so a NERD program may omit any of them
+__attribute__((weak)) extern double render_404(void);
+__attribute__((weak)) extern double render_about(void);
+__attribute__((weak)) extern double render_admin(void);
+__attribute__((weak)) extern double render_plugins(void);
+__attribute__((weak)) extern double render_raw(void);
+
+static double (* const route_renders[ROUTE_COUNT])(void) = {
+    render_404,
+    0,
+    0,
+    0,
+    0,
+    0,
+    render_about,
+    0,
+    0,
+    0,
+    0,
+    0,
+    render_admin,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    render_plugins,
+    render_raw,
+};
+
+typedef struct route_trie_node {
+    unsigned short edge_start, edge_count;    // route_trie_edge_byte/_next
+    unsigned short exact_start, exact_count;  // route_trie_refs: path ends here
+    unsigned short param_start, param_count;  // route_trie_refs: :param starts here
+} route_trie_node;
+
+static const route_trie_node route_trie_nodes[104] = {
+    { 0, 1, 0, 0, 0, 0 },
+    { 1, 6, 0, 1, 1, 0 },
+    { 7, 3, 1, 0, 1, 0 },
+    { 10, 1, 1, 0, 1, 0 },
+    { 11, 1, 1, 0, 1, 0 },
+    { 12, 6, 1, 0, 1, 0 },
+    { 18, 1, 1, 0, 1, 0 },
+    { 19, 1, 1, 0, 1, 0 },
+    { 20, 1, 1, 0, 1, 0 },
+    { 21, 1, 1, 0, 1, 0 },
+    { 22, 1, 1, 1, 2, 0 },
+    { 23, 0, 2, 0, 2, 3 },
+    { 23, 1, 5, 0, 5, 0 },
+    { 24, 1, 5, 0, 5, 0 },
+    { 25, 1, 5, 0, 5, 0 },
+    { 26, 0, 5, 1, 6, 0 },
+    { 26, 1, 6, 0, 6, 0 },
+    { 27, 1, 6, 0, 6, 0 },
+    { 28, 1, 6, 0, 6, 0 },
+    { 29, 1, 6, 1, 7, 0 },
+    { 30, 0, 7, 0, 7, 1 },
+    { 30, 1, 8, 0, 8, 0 },
+    { 31, 1, 8, 0, 8, 0 },
+    { 32, 1, 8, 0, 8, 0 },
+    { 33, 1, 8, 0, 8, 0 },
+    { 34, 1, 8, 0, 8, 0 },
+    { 35, 1, 8, 0, 8, 0 },
+    { 36, 1, 8, 0, 8, 0 },
+    { 37, 1, 8, 0, 8, 0 },
+    { 38, 1, 8, 0, 8, 0 },
+    { 39, 1, 8, 0, 8, 0 },
+    { 40, 0, 8, 0, 8, 1 },
+    { 40, 1, 9, 0, 9, 0 },
+    { 41, 1, 9, 0, 9, 0 },
+    { 42, 1, 9, 0, 9, 0 },
+    { 43, 1, 9, 0, 9, 0 },
+    { 44, 1, 9, 0, 9, 0 },
+    { 45, 2, 9, 0, 9, 0 },
+    { 47, 1, 9, 0, 9, 0 },
+    { 48, 1, 9, 0, 9, 0 },
+    { 49, 1, 9, 0, 9, 0 },
+    { 50, 0, 9, 1, 10, 0 },
+    { 50, 1, 10, 0, 10, 0 },
+    { 51, 1, 10, 0, 10, 0 },
+    { 52, 1, 10, 0, 10, 0 },
+    { 53, 1, 10, 0, 10, 0 },
+    { 54, 1, 10, 0, 10, 0 },
+    { 55, 1, 10, 0, 10, 0 },
+    { 56, 1, 10, 0, 10, 0 },
+    { 57, 0, 10, 1, 11, 0 },
+    { 57, 1, 11, 0, 11, 0 },
+    { 58, 1, 11, 0, 11, 0 },
+    { 59, 1, 11, 0, 11, 0 },
+    { 60, 0, 11, 1, 12, 0 },
+    { 60, 2, 12, 0, 12, 0 },
+    { 62, 1, 12, 0, 12, 0 },
+    { 63, 1, 12, 0, 12, 0 },
+    { 64, 1, 12, 0, 12, 0 },
+    { 65, 1, 12, 0, 12, 0 },
+    { 66, 1, 12, 0, 12, 0 },
+    { 67, 0, 12, 1, 13, 0 },
+    { 67, 1, 13, 0, 13, 0 },
+    { 68, 1, 13, 0, 13, 0 },
+    { 69, 1, 13, 0, 13, 0 },
+    { 70, 1, 13, 0, 13, 0 },
+    { 71, 1, 13, 0, 13, 0 },
+    { 72, 1, 13, 0, 13, 0 },
+    { 73, 1, 13, 0, 13, 0 },
+    { 74, 1, 13, 0, 13, 0 },
+    { 75, 0, 13, 1, 14, 0 },
+    { 75, 1, 14, 0, 14, 0 },
+    { 76, 1, 14, 0, 14, 0 },
+    { 77, 0, 14, 1, 15, 0 },
+    { 77, 1, 15, 0, 15, 0 },
+    { 78, 1, 15, 0, 15, 0 },
+    { 79, 1, 15, 0, 15, 0 },
+    { 80, 0, 15, 0, 15, 1 },
+    { 80, 1, 16, 0, 16, 0 },
+    { 81, 1, 16, 0, 16, 0 },
+    { 82, 1, 16, 0, 16, 0 },
+    { 83, 1, 16, 0, 16, 0 },
+    { 84, 1, 16, 0, 16, 0 },
+    { 85, 1, 16, 0, 16, 0 },
+    { 86, 1, 16, 0, 16, 0 },
+    { 87, 1, 16, 0, 16, 0 },
+    { 88, 1, 16, 1, 17, 0 },
+    { 89, 1, 17, 0, 17, 0 },
+    { 90, 0, 17, 1, 18, 0 },
+    { 90, 1, 18, 0, 18, 0 },
+    { 91, 1, 18, 0, 18, 0 },
+    { 92, 1, 18, 0, 18, 0 },
+    { 93, 1, 18, 0, 18, 0 },
+    { 94, 1, 18, 0, 18, 0 },
+    { 95, 1, 18, 0, 18, 0 },
+    { 96, 0, 18, 1, 19, 0 },
+    { 96, 1, 19, 0, 19, 0 },
+    { 97, 1, 19, 0, 19, 0 },
+    { 98, 1, 19, 0, 19, 0 },
+    { 99, 1, 19, 0, 19, 0 },
+    { 100, 1, 19, 0, 19, 0 },
+    { 101, 1, 19, 0, 19, 0 },
+    { 102, 0, 19, 1, 20, 0 },
+    { 102, 1, 20, 0, 20, 0 },
+    { 103, 0, 20, 1, 21, 0 },
+};
+
+static const unsigned char route_trie_edge_byte[103] = {
+    '/', 'a', 'b', 'f', 'm', 'p', 'r', 'b', 'd', 'p', 'i', '/', 'a', 'm', 'p', 'r',
+    's', 't', 'o', 's', 't', 's', '/', 'o', 'u', 't', 'l', 'o', 'g', '/', 'g', '-',
+    'w', 'e', 'b', 'h', 'o', 'o', 'k', '/', 'd', 'm', 'i', 'n', '/', 'g', 's', 'a',
+    'v', 'e', 'e', 'n', 'e', 'r', 'a', 't', 'e', 'm', 'i', 'n', 'a', 's', 's', '.',
+    'x', 'm', 'l', 'e', 'e', 'd', '.', 'j', 's', 'o', 'n', 'c', 'p', 'a', 'g', '/',
+    'u', 'b', 's', 'c', 'r', 'i', 'b', 'e', 'r', 's', 'e', 't', 'r', 'i', 'c', 's',
+    'l', 'u', 'g', 'i', 'n', 's', 'w',
+};
+
+static const unsigned short route_trie_edge_next[103] = {
+    1, 2, 16, 61, 70, 95, 54, 12, 50, 3, 4, 5, 32, 88, 6, 73,
+    77, 21, 7, 8, 9, 10, 11, 13, 14, 15, 17, 18, 19, 20, 22, 23,
+    24, 25, 26, 27, 28, 29, 30, 31, 33, 34, 35, 36, 37, 42, 38, 39,
+    40, 41, 43, 44, 45, 46, 47, 48, 49, 51, 52, 53, 102, 55, 56, 57,
+    58, 59, 60, 62, 63, 64, 65, 66, 67, 68, 69, 71, 72, 74, 75, 76,
+    78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 89, 90, 91, 92, 93, 94,
+    96, 97, 98, 99, 100, 101, 103,
+};
+
+static const unsigned char route_trie_refs[21] = {
+    ROUTE_HOME, ROUTE_API_POSTS, ROUTE_API_POST, ROUTE_API_POST_SAVE,
+    ROUTE_API_POST_DELETE, ROUTE_ABOUT, ROUTE_BLOG, ROUTE_POST,
+    ROUTE_TG_WEBHOOK, ROUTE_ADMIN_SAVE, ROUTE_ADMIN_GENERATE, ROUTE_ADMIN,
+    ROUTE_RSS, ROUTE_FEED, ROUTE_MCP, ROUTE_RAG,
+    ROUTE_SUBSCRIBE, ROUTE_SUBSCRIBERS, ROUTE_METRICS, ROUTE_PLUGINS,
+    ROUTE_RAW,
+};
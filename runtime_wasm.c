@@ -3,27 +3,58 @@
  *
  * This file provides implementations for NERD's external symbols, delegating
  * I/O operations to JavaScript imports. Compiled with:
- *   clang --target=wasm32-unknown-unknown -O2 -c runtime_wasm.c -o runtime_wasm.o
+ *   clang --target=wasm32-unknown-unknown -O2 -msimd128 -mbulk-memory \
+ *         -c runtime_wasm.c -o runtime_wasm.o
+ * Without -msimd128 / -mbulk-memory the string kernels fall back to scalar loops.
  */
 
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#include "routes_gen.h"
+
 // ============================================================================
 // WASM Imports (provided by JavaScript host)
 // ============================================================================
 
-// Console output
-__attribute__((import_module("env"), import_name("js_print_string")))
-extern void js_print_string(const char* str);
+// Console output: `len` bytes of UTF-8 starting at `ptr` (not NUL-terminated)
+__attribute__((import_module("env"), import_name("js_write")))
+extern void js_write(const char* ptr, unsigned int len);
 
-__attribute__((import_module("env"), import_name("js_print_number")))
-extern void js_print_number(double num);
 
-// CMS-specific imports from JS host
+// CMS-specific imports from JS host. Both return the full encoded length.
 __attribute__((import_module("env"), import_name("js_get_request_path")))
 extern int js_get_request_path(char* buf, int bufsize);
 
 __attribute__((import_module("env"), import_name("js_get_request_method")))
 extern int js_get_request_method(char* buf, int bufsize);
 
+__attribute__((import_module("env"), import_name("js_get_request_origin")))
+extern int js_get_request_origin(char* buf, int bufsize);
+
+// Raw query string without the leading '?'
+__attribute__((import_module("env"), import_name("js_get_request_query")))
+extern int js_get_request_query(char* buf, int bufsize);
+
+// Async host calls. The host may suspend the calling render on these (JSPI,
+// or asyncify in builds that run wasm-opt --asyncify) and resume it once its
+// promise settles. Each stages its result on the host and returns the byte
+// length, or -1 for none; js_take_result copies the staged bytes out.
+__attribute__((import_module("env"), import_name("js_http_fetch")))
+extern int js_http_fetch(const char* method, unsigned int method_len, const char* url, unsigned int url_len,
+                         const char* headers, unsigned int headers_len, const char* body, unsigned int body_len);
+
+__attribute__((import_module("env"), import_name("js_kv_get")))
+extern int js_kv_get(const char* key, unsigned int key_len);
+
+// The request's post list as a packed record table (see "Post Records")
+__attribute__((import_module("env"), import_name("js_load_posts")))
+extern int js_load_posts(void);
+
+__attribute__((import_module("env"), import_name("js_take_result")))
+extern void js_take_result(char* ptr, unsigned int len);
+
 // Memory allocation from JS (for strings returned from HTTP, etc.)
 __attribute__((export_name("wasm_alloc")))
 char* wasm_alloc(unsigned long size);
@@ -31,51 +62,361 @@ char* wasm_alloc(unsigned long size);
 __attribute__((export_name("wasm_free")))
 void wasm_free(char* ptr);
 
+// Per-instance setup, run once before the first request (or at build time)
+__attribute__((export_name("wasm_init")))
+void wasm_init(void);
+
+#define WASM_PAGE_SIZE 65536
+
+// ============================================================================
+// Runtime Telemetry
+// ============================================================================
+//
+// One flat struct of 32-bit counters so the host can read it with a single
+// Uint32Array view. Per-request counters are cleared by wasm_reset_heap.
+
+typedef struct wasm_stats {
+    unsigned int heap_high_water;           // Peak heap bytes in use this request
+    unsigned int memory_bytes;              // Current size of linear memory
+    unsigned int alloc_count;               // wasm_alloc calls this request
+    unsigned int free_count;                // wasm_free calls this request
+    unsigned int request_bytes;             // Bytes requested through wasm_alloc
+    unsigned int failed_allocs;             // Allocations that could not grow memory
+    unsigned int shared_buffer_high_water;  // Largest payload written to shared_buffer
+    unsigned int shared_buffer_truncations; // Host writes past the reserved capacity
+} wasm_stats;
+
+static wasm_stats stats;
+
+__attribute__((export_name("wasm_get_stats")))
+wasm_stats* wasm_get_stats(void) {
+    stats.memory_bytes = (unsigned int)(__builtin_wasm_memory_size(0) * WASM_PAGE_SIZE);
+    return &stats;
+}
+
 // ============================================================================
-// Simple Memory Management
+// Memory Management (size-class allocator over growable linear memory)
 // ============================================================================
+//
+// The heap starts at __heap_base (placed by wasm-ld after data and stack) and
+// extends to the end of linear memory, which is grown with memory.grow on
+// demand. Small requests are rounded up to a power-of-two size class and
+// recycled through per-class free lists; anything larger than the biggest
+// class takes the large-object path with its own first-fit free list. Every
+// block carries a header so wasm_free knows where to return it.
+
+#define HEAP_ALIGN 8
+#define SIZE_CLASS_MIN_SHIFT 4                   // smallest class: 16 bytes
+#define SIZE_CLASS_COUNT 8                       // 16 .. 2048 bytes
+#define SIZE_CLASS_MAX (1UL << (SIZE_CLASS_MIN_SHIFT + SIZE_CLASS_COUNT - 1))
+#define LARGE_CLASS SIZE_CLASS_COUNT
+#define LARGE_GRANULE 256
+// Freed large blocks are never split, coalesced with their neighbours or
+// given back to the top of the heap: one is only reused by a later request
+// between half its size and its size. The space comes back at
+// wasm_reset_heap or when an arena mark below it is released.
+
+extern unsigned char __heap_base;  // Provided by wasm-ld
+
+typedef struct block_header {
+    unsigned long size;      // Usable payload size in bytes
+    unsigned long class_id;  // Size class index, or LARGE_CLASS
+} block_header;
+
+// Largest request that can be rounded up to LARGE_GRANULE and given a header
+// without wrapping a 32-bit size; anything bigger cannot fit in memory anyway
+#define ALLOC_SIZE_MAX (0xFFFFFFFFUL - LARGE_GRANULE - sizeof(block_header))
+
+typedef struct free_block {
+    block_header header;
+    struct free_block* next;
+} free_block;
+
+static char* heap_start = 0;
+static char* heap_ptr = 0;
+static char* heap_limit = 0;
+static free_block* small_free[SIZE_CLASS_COUNT];
+static free_block* large_free = 0;
+
+#define ARENA_STACK_DEPTH 32
+
+static char* arena_stack[ARENA_STACK_DEPTH];
+static int arena_depth = 0;
+
+static void request_state_reset(void);  // Defined at the end of this file
+
+static unsigned long align_up(unsigned long n, unsigned long a) {
+    return (n + a - 1) & ~(a - 1);
+}
+
+static void heap_init(void) {
+    heap_start = (char*)align_up((unsigned long)&__heap_base, HEAP_ALIGN);
+    heap_ptr = heap_start;
+    heap_limit = (char*)(__builtin_wasm_memory_size(0) * WASM_PAGE_SIZE);
+}
+
+// Carve `bytes` from the top of the heap, growing linear memory if needed.
+static char* heap_reserve(unsigned long bytes) {
+    if (!heap_start) heap_init();
+    if ((unsigned long)(heap_limit - heap_ptr) < bytes) {
+        unsigned long missing = bytes - (unsigned long)(heap_limit - heap_ptr);
+        // Not align_up: rounding a near-4GB shortfall would wrap
+        unsigned long pages = missing / WASM_PAGE_SIZE + (missing % WASM_PAGE_SIZE != 0);
+        if (__builtin_wasm_memory_grow(0, pages) == (unsigned long)-1) return 0;
+        heap_limit += pages * WASM_PAGE_SIZE;
+    }
+    char* ptr = heap_ptr;
+    heap_ptr += bytes;
+    if ((unsigned int)(heap_ptr - heap_start) > stats.heap_high_water) {
+        stats.heap_high_water = (unsigned int)(heap_ptr - heap_start);
+    }
+    return ptr;
+}
+
+static int size_class_for(unsigned long size) {
+    int cls = 0;
+    unsigned long cap = 1UL << SIZE_CLASS_MIN_SHIFT;
+    while (cap < size) { cap <<= 1; cls++; }
+    return cls;
+}
+
+static char* alloc_small(unsigned long size) {
+    int cls = size_class_for(size);
+    free_block* blk = small_free[cls];
+    if (blk) {
+        small_free[cls] = blk->next;
+        return (char*)(&blk->header + 1);
+    }
+    unsigned long cap = 1UL << (SIZE_CLASS_MIN_SHIFT + cls);
+    block_header* hdr = (block_header*)heap_reserve(sizeof(block_header) + cap);
+    if (!hdr) return 0;
+    hdr->size = cap;
+    hdr->class_id = cls;
+    return (char*)(hdr + 1);
+}
 
-static char heap[131072];  // 128KB heap (increased for HTML templates)
-static int heap_offset = 0;
+static char* alloc_large(unsigned long size) {
+    unsigned long cap = align_up(size, LARGE_GRANULE);
+    // First fit, but refuse blocks more than twice the request so a single
+    // huge free block is not burned on a small large-object request.
+    free_block** link = &large_free;
+    while (*link) {
+        free_block* blk = *link;
+        if (blk->header.size >= cap && blk->header.size / 2 <= cap) {
+            *link = blk->next;
+            return (char*)(&blk->header + 1);
+        }
+        link = &blk->next;
+    }
+    block_header* hdr = (block_header*)heap_reserve(sizeof(block_header) + cap);
+    if (!hdr) return 0;
+    hdr->size = cap;
+    hdr->class_id = LARGE_CLASS;
+    return (char*)(hdr + 1);
+}
 
 char* wasm_alloc(unsigned long size) {
-    if (heap_offset + size > (unsigned long)sizeof(heap)) return 0;
-    char* ptr = &heap[heap_offset];
-    heap_offset += size;
+    if (size == 0) size = 1;
+    stats.alloc_count++;
+    stats.request_bytes += (unsigned int)size;
+    char* ptr = size > ALLOC_SIZE_MAX ? 0
+              : size <= SIZE_CLASS_MAX ? alloc_small(size) : alloc_large(size);
+    // Out of linear memory (or a size no memory could hold): count it, then
+    // trap instead of handing callers a null pointer. The counters stay
+    // readable from the host after the trap.
+    if (!ptr) {
+        stats.failed_allocs++;
+        __builtin_trap();
+    }
     return ptr;
 }
 
 void wasm_free(char* ptr) {
-    (void)ptr;  // No-op for bump allocator
+    if (!ptr) return;
+    stats.free_count++;
+    free_block* blk = (free_block*)((block_header*)ptr - 1);
+    if (blk->header.class_id == LARGE_CLASS) {
+        blk->next = large_free;
+        large_free = blk;
+    } else {
+        blk->next = small_free[blk->header.class_id];
+        small_free[blk->header.class_id] = blk;
+    }
 }
 
-// Reset heap for each request
+static int runtime_ready = 0;
+
+static void isolate_tables_init(void);
+
+// Reset heap for each request. Linear memory never shrinks, so a reused
+// instance keeps serving requests from the pages it has already grown.
 __attribute__((export_name("wasm_reset_heap")))
 void wasm_reset_heap(void) {
-    heap_offset = 0;
+    if (!runtime_ready) wasm_init();
+    heap_ptr = heap_start;
+    for (int i = 0; i < SIZE_CLASS_COUNT; i++) small_free[i] = 0;
+    large_free = 0;
+    arena_depth = 0;
+    wasm_stats cleared = {0};
+    stats = cleared;
+    request_state_reset();
+}
+
+// Builds the per-instance state (see "Isolate State") at the bottom of the heap
+// and moves heap_start above it, so request resets never release it.
+// tools/wizer.mjs calls this at build time and snapshots the result into the
+// module's data segments; unsnapshotted builds run it on the first reset.
+void wasm_init(void) {
+    if (runtime_ready) return;
+    heap_init();
+    isolate_tables_init();
+    heap_start = (char*)align_up((unsigned long)heap_ptr, HEAP_ALIGN);
+    runtime_ready = 1;
+    wasm_reset_heap();
 }
 
 // ============================================================================
-// Data Passing (Shared Buffer)
+// Arena Checkpoints (mark/release)
 // ============================================================================
+//
+// A mark is the current top of the heap. Releasing it pops everything bumped
+// since, and drops free-list entries that lived above it. Blocks recycled from
+// free lists below the mark stay allocated until wasm_reset_heap. Marks are
+// passed as doubles so NERD code can hold them like any other value.
 
-static char shared_buffer[65536]; // 64KB for blog lists and post data
+static void drop_free_above(free_block** link, char* mark) {
+    while (*link) {
+        if ((char*)*link >= mark) *link = (*link)->next;
+        else link = &(*link)->next;
+    }
+}
 
-__attribute__((export_name("wasm_get_shared_buffer")))
-char* wasm_get_shared_buffer(void) {
-    return shared_buffer;
+static void arena_release_to(char* mark) {
+    if (mark < heap_start || mark > heap_ptr) return;
+    for (int i = 0; i < SIZE_CLASS_COUNT; i++) drop_free_above(&small_free[i], mark);
+    drop_free_above(&large_free, mark);
+    heap_ptr = mark;
 }
 
-__attribute__((used))
-double print_buffer(void) {
-    js_print_string(shared_buffer);
+__attribute__((export_name("wasm_arena_mark")))
+double wasm_arena_mark(void) {
+    if (!heap_start) heap_init();
+    return (double)(unsigned long)heap_ptr;
+}
+
+__attribute__((export_name("wasm_arena_release")))
+double wasm_arena_release(double mark) {
+    arena_release_to((char*)(unsigned long)mark);
     return 0.0;
 }
 
+// Nested arenas for NERD templates: `call wasm_arena_push` before building a
+// fragment, `call wasm_arena_pop` once it has been written out.
+__attribute__((export_name("wasm_arena_push")))
+double wasm_arena_push(void) {
+    if (!heap_start) heap_init();
+    if (arena_depth < ARENA_STACK_DEPTH) arena_stack[arena_depth] = heap_ptr;
+    arena_depth++;
+    return (double)arena_depth;
+}
+
+__attribute__((export_name("wasm_arena_pop")))
+double wasm_arena_pop(void) {
+    if (arena_depth == 0) return 0.0;
+    arena_depth--;
+    if (arena_depth < ARENA_STACK_DEPTH) arena_release_to(arena_stack[arena_depth]);
+    return (double)arena_depth;
+}
+
+// Keeps everything allocated so far past the arenas currently pushed. Data
+// pulled from the host mid-template belongs to the request, not to whichever
+// fragment asked for it first; the fragment's own blocks below it stay until
+// wasm_reset_heap.
+static void arena_keep_all(void) {
+    int depth = arena_depth < ARENA_STACK_DEPTH ? arena_depth : ARENA_STACK_DEPTH;
+    for (int i = 0; i < depth; i++) arena_stack[i] = heap_ptr;
+}
+
+// ============================================================================
+// String Kernels
+// ============================================================================
+//
+// Byte-string primitives used by routing, output and parsing. With SIMD128
+// they look at 16 bytes per step; copies lower to `memory.copy` with
+// bulk-memory. Each kernel keeps a scalar path for builds without those
+// features and for short tails.
+
+#ifdef __wasm_simd128__
+#define SIMD_WIDTH 16
+
+// Lane mask (bit i = byte i) of the bytes equal to `c` in the 16 at `p`
+static unsigned int simd_match(const char* p, v128_t c) {
+    return wasm_i8x16_bitmask(wasm_i8x16_eq(wasm_v128_load(p), c));
+}
+#endif
+
+// Exported for compiler-generated copies as well as the runtime itself.
+// Named memcpy/memmove/memset, so the optimizer never rewrites the fallback
+// loops into calls to themselves.
+__attribute__((used))
+void* memcpy(void* dst, const void* src, unsigned long n) {
+#ifdef __wasm_bulk_memory__
+    __builtin_memcpy(dst, src, n);
+#else
+    char* d = (char*)dst;
+    const char* s = (const char*)src;
+    for (unsigned long i = 0; i < n; i++) d[i] = s[i];
+#endif
+    return dst;
+}
+
+__attribute__((used))
+void* memmove(void* dst, const void* src, unsigned long n) {
+#ifdef __wasm_bulk_memory__
+    __builtin_memmove(dst, src, n);
+#else
+    char* d = (char*)dst;
+    const char* s = (const char*)src;
+    if (d < s) {
+        for (unsigned long i = 0; i < n; i++) d[i] = s[i];
+    } else {
+        for (unsigned long i = n; i > 0; i--) d[i - 1] = s[i - 1];
+    }
+#endif
+    return dst;
+}
+
+__attribute__((used))
+void* memset(void* dst, int c, unsigned long n) {
+#ifdef __wasm_bulk_memory__
+    __builtin_memset(dst, c, n);
+#else
+    char* d = (char*)dst;
+    for (unsigned long i = 0; i < n; i++) d[i] = (char)c;
+#endif
+    return dst;
+}
+
 static unsigned long my_strlen(const char* s) {
+    if (!s) return 0;
+#ifdef __wasm_simd128__
+    // Aligned loads never cross the end of linear memory (a multiple of 64KB),
+    // so reading the bytes around the string is safe; lanes before `s` are
+    // shifted out of the first mask.
+    v128_t zero = wasm_i8x16_splat(0);
+    const char* p = (const char*)((unsigned long)s & ~(unsigned long)(SIMD_WIDTH - 1));
+    unsigned int mask = simd_match(p, zero) >> (s - p);
+    if (mask) return (unsigned long)__builtin_ctz(mask);
+    for (;;) {
+        p += SIMD_WIDTH;
+        mask = simd_match(p, zero);
+        if (mask) return (unsigned long)(p - s) + __builtin_ctz(mask);
+    }
+#else
     unsigned long len = 0;
-    while (s && s[len]) len++;
+    while (s[len]) len++;
     return len;
+#endif
 }
 
 // Exported strlen - called by NERD-generated code
@@ -84,147 +425,3465 @@ unsigned long strlen(const char* s) {
     return my_strlen(s);
 }
 
-static int my_strcmp(const char* a, const char* b) {
-    while (*a && *b && *a == *b) { a++; b++; }
-    return *a - *b;
+// Index of the first `c` in p[0..len), or len if there is none
+static unsigned int mem_find_byte(const char* p, unsigned int len, char c) {
+    unsigned int i = 0;
+#ifdef __wasm_simd128__
+    v128_t needle = wasm_i8x16_splat(c);
+    for (; i + SIMD_WIDTH <= len; i += SIMD_WIDTH) {
+        unsigned int mask = simd_match(p + i, needle);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+#endif
+    for (; i < len; i++) {
+        if (p[i] == c) return i;
+    }
+    return len;
+}
+
+// Three-way byte comparison of a[0..len) and b[0..len), memcmp style
+static int mem_compare(const char* a, const char* b, unsigned int len) {
+    unsigned int i = 0;
+#ifdef __wasm_simd128__
+    for (; i + SIMD_WIDTH <= len; i += SIMD_WIDTH) {
+        unsigned int same = wasm_i8x16_bitmask(wasm_i8x16_eq(wasm_v128_load(a + i), wasm_v128_load(b + i)));
+        if (same != 0xFFFF) {
+            i += __builtin_ctz(~same);
+            return (int)(unsigned char)a[i] - (int)(unsigned char)b[i];
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        if (a[i] != b[i]) return (int)(unsigned char)a[i] - (int)(unsigned char)b[i];
+    }
+    return 0;
 }
 
-static int my_strncmp(const char* a, const char* b, int n) {
-    while (n > 0 && *a && *b && *a == *b) { a++; b++; n--; }
-    return n == 0 ? 0 : *a - *b;
+static int mem_equal(const char* a, const char* b, unsigned int len) {
+    unsigned int i = 0;
+#ifdef __wasm_simd128__
+    for (; i + SIMD_WIDTH <= len; i += SIMD_WIDTH) {
+        if (!wasm_i8x16_all_true(wasm_i8x16_eq(wasm_v128_load(a + i), wasm_v128_load(b + i)))) return 0;
+    }
+#endif
+    for (; i < len; i++) {
+        if (a[i] != b[i]) return 0;
+    }
+    return 1;
 }
 
-static void my_strcpy(char* dst, const char* src) {
-    while (*src) *dst++ = *src++;
-    *dst = 0;
+// Index of the first occurrence of needle in hay, or -1. The SIMD path
+// compares the needle's first and last bytes against 16 candidate positions
+// at once and only verifies the middle where both match.
+static int mem_find(const char* hay, unsigned int hay_len, const char* needle, unsigned int needle_len) {
+    if (needle_len == 0) return 0;
+    if (needle_len > hay_len) return -1;
+    unsigned int last = hay_len - needle_len;
+    unsigned int i = 0;
+#ifdef __wasm_simd128__
+    v128_t first = wasm_i8x16_splat(needle[0]);
+    v128_t tail = wasm_i8x16_splat(needle[needle_len - 1]);
+    for (; i + SIMD_WIDTH - 1 <= last; i += SIMD_WIDTH) {
+        unsigned int mask = simd_match(hay + i, first) & simd_match(hay + i + needle_len - 1, tail);
+        while (mask) {
+            unsigned int at = i + __builtin_ctz(mask);
+            if (mem_equal(hay + at + 1, needle + 1, needle_len - 1)) return (int)at;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    while (i <= last) {
+        i += mem_find_byte(hay + i, last - i + 1, needle[0]);
+        if (i > last) break;
+        if (mem_equal(hay + i + 1, needle + 1, needle_len - 1)) return (int)i;
+        i++;
+    }
+    return -1;
 }
 
 // ============================================================================
-// CMS Runtime Functions (called by NERD)
+// String Slices
 // ============================================================================
+//
+// A (ptr, len) view over bytes in linear memory. Slices are borrowed and not
+// NUL-terminated, so their length is known without rescanning the bytes.
 
-// Get request path - returns pointer to static buffer
-static char request_path_buf[256];
-__attribute__((export_name("nerd_cms_get_path")))
-const char* nerd_cms_get_path(void) {
-    js_get_request_path(request_path_buf, sizeof(request_path_buf));
-    return request_path_buf;
+typedef struct nerd_slice {
+    const char* ptr;
+    unsigned int len;
+} nerd_slice;
+
+static nerd_slice slice_make(const char* ptr, unsigned int len) {
+    nerd_slice s = { ptr, len };
+    return s;
 }
 
-// Get request method
-static char request_method_buf[16];
-__attribute__((export_name("nerd_cms_get_method")))
-const char* nerd_cms_get_method(void) {
-    js_get_request_method(request_method_buf, sizeof(request_method_buf));
-    return request_method_buf;
+static nerd_slice slice_from_cstr(const char* s) {
+    return slice_make(s, (unsigned int)my_strlen(s));
 }
 
-// Route matching helpers
-__attribute__((export_name("nerd_cms_route_eq")))
-int nerd_cms_route_eq(const char* path) {
-    nerd_cms_get_path();
-    return my_strcmp(request_path_buf, path) == 0;
+static int slice_eq(nerd_slice a, nerd_slice b) {
+    return a.len == b.len && mem_equal(a.ptr, b.ptr, a.len);
 }
 
-__attribute__((export_name("nerd_cms_route_starts")))
-int nerd_cms_route_starts(const char* prefix) {
-    nerd_cms_get_path();
-    return my_strncmp(request_path_buf, prefix, my_strlen(prefix)) == 0;
+static int slice_starts_with(nerd_slice s, nerd_slice prefix) {
+    if (prefix.len > s.len) return 0;
+    return slice_eq(slice_make(s.ptr, prefix.len), prefix);
 }
 
-// ============================================================================
-// printf / puts Implementations (NERD uses printf for 'out')
-// ============================================================================
+// Compare against a NUL-terminated literal in one pass, without a strlen.
+static int slice_eq_cstr(nerd_slice s, const char* lit) {
+    unsigned int i = 0;
+    for (; i < s.len; i++) {
+        if (lit[i] == 0 || lit[i] != s.ptr[i]) return 0;
+    }
+    return lit[i] == 0;
+}
 
-// The LLVM optimizer may convert printf("%s\n", str) to puts(str)
-int puts(const char* str) {
-    js_print_string(str);
-    return 0;
+static int slice_starts_with_cstr(nerd_slice s, const char* lit) {
+    unsigned int i = 0;
+    for (; lit[i]; i++) {
+        if (i >= s.len || lit[i] != s.ptr[i]) return 0;
+    }
+    return 1;
 }
 
-// Variadic printf - we handle the two formats NERD uses:
-// "%s\n" -> print string
-// "%g\n" -> print number
-// We use __builtin_va_* for wasm32
-int printf(const char* fmt, ...) {
-    // Check format string to determine type
-    // "%s\n" = print string, "%g\n" = print number
-    
-    __builtin_va_list args;
-    __builtin_va_start(args, fmt);
-    
-    // Simple format detection
-    if (fmt[0] == '%' && fmt[1] == 's') {
-        const char* str = __builtin_va_arg(args, const char*);
-        js_print_string(str);
-    } else if (fmt[0] == '%' && (fmt[1] == 'g' || fmt[1] == 'f' || fmt[1] == '.')) {
-        double num = __builtin_va_arg(args, double);
-        js_print_number(num);
-    } else {
-        // Unknown format, try to print as string
-        js_print_string(fmt);
-    }
-    
-    __builtin_va_end(args);
-    return 0;
+// Byte-order comparison; a proper prefix sorts first
+static int slice_compare(nerd_slice a, nerd_slice b) {
+    int c = mem_compare(a.ptr, b.ptr, a.len < b.len ? a.len : b.len);
+    if (c) return c;
+    return (a.len > b.len) - (a.len < b.len);
 }
 
-// ============================================================================
-// HTTP Runtime Stubs
-// ============================================================================
+// Lower-case form of a two-byte UTF-8 code point (U+0080..U+07FF) for the
+// Latin-1, Latin Extended-A, Greek and Cyrillic capitals; the result needs
+// two bytes as well. Anything else maps to itself.
+static unsigned int lower_code_point(unsigned int cp) {
+    if ((cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) || (cp >= 0x391 && cp <= 0x3AB && cp != 0x3A2) ||
+        (cp >= 0x410 && cp <= 0x42F)) return cp + 0x20;
+    if (cp >= 0x400 && cp <= 0x40F) return cp + 0x50;
+    if ((cp >= 0x100 && cp <= 0x12F) || (cp >= 0x132 && cp <= 0x137) || (cp >= 0x14A && cp <= 0x177) ||
+        (cp >= 0x460 && cp <= 0x481) || (cp >= 0x48A && cp <= 0x4BF)) return cp | 1;
+    if ((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E)) return cp & 1 ? cp + 1 : cp;
+    if (cp == 0x178) return 0xFF;
+    if (cp == 0x386) return 0x3AC;
+    if (cp >= 0x388 && cp <= 0x38A) return cp + 0x25;
+    if (cp == 0x38C) return 0x3CC;
+    if (cp == 0x38E || cp == 0x38F) return cp + 0x3F;
+    return cp;
+}
 
-char* nerd_http_get(const char* url) { (void)url; return 0; }
-char* nerd_http_post(const char* url, const char* body) { (void)url; (void)body; return 0; }
-void nerd_http_free(char* ptr) { (void)ptr; }
-char* nerd_http_get_json(const char* url) { (void)url; return 0; }
-char* nerd_http_post_json(const char* url, const char* body) { (void)url; (void)body; return 0; }
-char* nerd_http_post_json_body(const char* url, const char* body) { (void)url; (void)body; return 0; }
-char* nerd_http_request(const char* m, const char* u, const char* h, const char* b) { (void)m;(void)u;(void)h;(void)b; return 0; }
-char* nerd_http_get_full(const char* url, const char* h) { (void)url;(void)h; return 0; }
-char* nerd_http_post_full(const char* u, const char* b, const char* h) { (void)u;(void)b;(void)h; return 0; }
-char* nerd_http_put(const char* u, const char* b, const char* h) { (void)u;(void)b;(void)h; return 0; }
-char* nerd_http_delete(const char* u, const char* h) { (void)u;(void)h; return 0; }
-char* nerd_http_patch(const char* u, const char* b, const char* h) { (void)u;(void)b;(void)h; return 0; }
-char* nerd_http_auth_bearer(const char* t) { (void)t; return 0; }
-char* nerd_http_auth_basic(const char* u, const char* p) { (void)u;(void)p; return 0; }
+// Lower-cases UTF-8 in place without changing its length: ASCII plus the
+// two-byte capitals above ("Über" -> "über"). Other scripts, and the few
+// capitals whose lower case has another length, are left as they are.
+static void utf8_lower(char* p, unsigned int len) {
+    for (unsigned int i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)p[i];
+        if (c >= 'A' && c <= 'Z') {
+            p[i] = (char)(c + 32);
+        } else if ((c & 0xE0) == 0xC0 && i + 1 < len && ((unsigned char)p[i + 1] & 0xC0) == 0x80) {
+            unsigned int cp = lower_code_point((c & 0x1Fu) << 6 | ((unsigned char)p[i + 1] & 0x3Fu));
+            p[i] = (char)(0xC0 | cp >> 6);
+            p[i + 1] = (char)(0x80 | (cp & 0x3F));
+            i++;
+        }
+    }
+}
 
 // ============================================================================
-// MCP Stubs
+// Hash Map
 // ============================================================================
+//
+// SwissTable-style open addressing. Each slot has a control byte (EMPTY,
+// DELETED, or the low 7 bits of the key's hash), and probing compares a group
+// of 16 control bytes at once, so a lookup usually reads one group and one
+// key. Tables and key copies live on the request heap (arena) and go away
+// with wasm_reset_heap or an arena release.
+
+#define MAP_GROUP 16
+#define MAP_EMPTY ((unsigned char)0x80)
+#define MAP_DELETED ((unsigned char)0xFE)
+
+typedef union nerd_map_value {
+    double number;
+    void* ptr;
+} nerd_map_value;
+
+typedef struct nerd_map_slot {
+    nerd_slice key;
+    nerd_map_value value;
+} nerd_map_slot;
+
+typedef struct nerd_map {
+    unsigned char* ctrl;     // capacity + MAP_GROUP bytes; the tail mirrors the first group
+    nerd_map_slot* slots;
+    unsigned int capacity;   // power of two, at least MAP_GROUP
+    unsigned int size;
+    unsigned int growth_left;
+} nerd_map;
+
+static unsigned int map_hash(const char* p, unsigned int len) {
+    unsigned int h = 2166136261u;
+    for (unsigned int i = 0; i < len; i++) {
+        h ^= (unsigned char)p[i];
+        h *= 16777619u;
+    }
+    // FNV-1a spreads poorly into the high bits used for h1; finish with fmix32
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// Bit i set where ctrl[i] == c, over the MAP_GROUP bytes at `ctrl`
+static unsigned int map_group_match(const unsigned char* ctrl, unsigned char c) {
+#ifdef __wasm_simd128__
+    return simd_match((const char*)ctrl, wasm_i8x16_splat((char)c));
+#else
+    unsigned int mask = 0;
+    for (unsigned int i = 0; i < MAP_GROUP; i++) {
+        if (ctrl[i] == c) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+static void map_set_ctrl(nerd_map* m, unsigned int i, unsigned char c) {
+    m->ctrl[i] = c;
+    if (i < MAP_GROUP) m->ctrl[m->capacity + i] = c;
+}
+
+static void map_alloc_table(nerd_map* m, unsigned int capacity) {
+    m->ctrl = (unsigned char*)wasm_alloc(capacity + MAP_GROUP);
+    m->slots = (nerd_map_slot*)wasm_alloc((unsigned long)capacity * sizeof(nerd_map_slot));
+    memset(m->ctrl, MAP_EMPTY, capacity + MAP_GROUP);
+    m->capacity = capacity;
+    m->growth_left = capacity - capacity / 8 - m->size;
+}
+
+// Probe sequence: group starts advance by 16, 32, 48, ... (triangular), which
+// visits every group of a power-of-two table.
+static int map_find(const nerd_map* m, nerd_slice key, unsigned int hash) {
+    unsigned int mask = m->capacity - 1;
+    unsigned int pos = (hash >> 7) & mask;
+    for (unsigned int stride = MAP_GROUP;; stride += MAP_GROUP) {
+        const unsigned char* group = m->ctrl + pos;
+        unsigned int hits = map_group_match(group, (unsigned char)(hash & 0x7F));
+        while (hits) {
+            unsigned int i = (pos + __builtin_ctz(hits)) & mask;
+            if (slice_eq(m->slots[i].key, key)) return (int)i;
+            hits &= hits - 1;
+        }
+        if (map_group_match(group, MAP_EMPTY)) return -1;
+        pos = (pos + stride) & mask;
+    }
+}
+
+// First EMPTY or DELETED slot on the key's probe sequence
+static unsigned int map_find_free(const nerd_map* m, unsigned int hash) {
+    unsigned int mask = m->capacity - 1;
+    unsigned int pos = (hash >> 7) & mask;
+    for (unsigned int stride = MAP_GROUP;; stride += MAP_GROUP) {
+        const unsigned char* group = m->ctrl + pos;
+        unsigned int free = map_group_match(group, MAP_EMPTY) | map_group_match(group, MAP_DELETED);
+        if (free) return (pos + __builtin_ctz(free)) & mask;
+        pos = (pos + stride) & mask;
+    }
+}
+
+// Rehashes into a table twice as large, or the same size when most of the
+// used slots are tombstones. Key copies are carried over, not re-copied.
+static void map_rehash(nerd_map* m) {
+    unsigned char* old_ctrl = m->ctrl;
+    nerd_map_slot* old_slots = m->slots;
+    unsigned int old_capacity = m->capacity;
+    unsigned int capacity = m->size >= old_capacity * 7 / 16 ? old_capacity * 2 : old_capacity;
+
+    map_alloc_table(m, capacity);
+    for (unsigned int i = 0; i < old_capacity; i++) {
+        if (old_ctrl[i] & 0x80) continue;
+        unsigned int hash = map_hash(old_slots[i].key.ptr, old_slots[i].key.len);
+        unsigned int j = map_find_free(m, hash);
+        map_set_ctrl(m, j, (unsigned char)(hash & 0x7F));
+        m->slots[j] = old_slots[i];
+    }
+    m->growth_left = capacity - capacity / 8 - m->size;
+    wasm_free((char*)old_ctrl);
+    wasm_free((char*)old_slots);
+}
+
+// Slot for `key`, inserting it (with a copied key and a zero value) if absent
+static nerd_map_slot* map_upsert(nerd_map* m, nerd_slice key) {
+    unsigned int hash = map_hash(key.ptr, key.len);
+    int found = map_find(m, key, hash);
+    if (found >= 0) return &m->slots[found];
+
+    if (!m->growth_left) map_rehash(m);
+    unsigned int i = map_find_free(m, hash);
+    if (m->ctrl[i] == MAP_EMPTY) m->growth_left--;
+    map_set_ctrl(m, i, (unsigned char)(hash & 0x7F));
+
+    char* copy = wasm_alloc(key.len ? key.len : 1);
+    memcpy(copy, key.ptr, key.len);
+    m->slots[i].key = slice_make(copy, key.len);
+    m->slots[i].value.ptr = 0;
+    m->slots[i].value.number = 0.0;
+    m->size++;
+    return &m->slots[i];
+}
+
+static nerd_map_slot* map_lookup(const nerd_map* m, nerd_slice key) {
+    int i = map_find(m, key, map_hash(key.ptr, key.len));
+    return i < 0 ? 0 : &m->slots[i];
+}
+
+// Room for `expected` keys before the first rehash
+__attribute__((export_name("nerd_map_new")))
+nerd_map* nerd_map_new(unsigned int expected) {
+    unsigned int capacity = MAP_GROUP;
+    while (capacity - capacity / 8 < expected) capacity *= 2;
+    nerd_map* m = (nerd_map*)wasm_alloc(sizeof(nerd_map));
+    m->size = 0;
+    map_alloc_table(m, capacity);
+    return m;
+}
+
+__attribute__((export_name("nerd_map_free")))
+void nerd_map_free(nerd_map* m) {
+    for (unsigned int i = 0; i < m->capacity; i++) {
+        if (!(m->ctrl[i] & 0x80)) wasm_free((char*)m->slots[i].key.ptr);
+    }
+    wasm_free((char*)m->ctrl);
+    wasm_free((char*)m->slots);
+    wasm_free((char*)m);
+}
+
+__attribute__((export_name("nerd_map_size")))
+unsigned int nerd_map_size(const nerd_map* m) {
+    return m->size;
+}
+
+__attribute__((export_name("nerd_map_has")))
+int nerd_map_has(const nerd_map* m, const char* key, unsigned int len) {
+    return map_lookup(m, slice_make(key, len)) != 0;
+}
+
+__attribute__((export_name("nerd_map_get_number")))
+double nerd_map_get_number(const nerd_map* m, const char* key, unsigned int len, double fallback) {
+    nerd_map_slot* slot = map_lookup(m, slice_make(key, len));
+    return slot ? slot->value.number : fallback;
+}
+
+__attribute__((export_name("nerd_map_get_ptr")))
+void* nerd_map_get_ptr(const nerd_map* m, const char* key, unsigned int len) {
+    nerd_map_slot* slot = map_lookup(m, slice_make(key, len));
+    return slot ? slot->value.ptr : 0;
+}
+
+__attribute__((export_name("nerd_map_set_number")))
+void nerd_map_set_number(nerd_map* m, const char* key, unsigned int len, double value) {
+    map_upsert(m, slice_make(key, len))->value.number = value;
+}
+
+__attribute__((export_name("nerd_map_set_ptr")))
+void nerd_map_set_ptr(nerd_map* m, const char* key, unsigned int len, void* value) {
+    map_upsert(m, slice_make(key, len))->value.ptr = value;
+}
+
+// Counting helper: adds `delta` (missing keys start at 0), returns the total
+__attribute__((export_name("nerd_map_add_number")))
+double nerd_map_add_number(nerd_map* m, const char* key, unsigned int len, double delta) {
+    nerd_map_slot* slot = map_upsert(m, slice_make(key, len));
+    slot->value.number += delta;
+    return slot->value.number;
+}
+
+__attribute__((export_name("nerd_map_remove")))
+int nerd_map_remove(nerd_map* m, const char* key, unsigned int len) {
+    nerd_slice k = slice_make(key, len);
+    int i = map_find(m, k, map_hash(key, len));
+    if (i < 0) return 0;
+    wasm_free((char*)m->slots[i].key.ptr);
+    map_set_ctrl(m, (unsigned int)i, MAP_DELETED);
+    m->size--;
+    return 1;
+}
+
+// Iteration: `for (int i = nerd_map_next(m, -1); i >= 0; i = nerd_map_next(m, i))`
+__attribute__((export_name("nerd_map_next")))
+int nerd_map_next(const nerd_map* m, int i) {
+    for (unsigned int j = (unsigned int)(i + 1); j < m->capacity; j++) {
+        if (!(m->ctrl[j] & 0x80)) return (int)j;
+    }
+    return -1;
+}
 
-char* nerd_mcp_list(const char* url) { (void)url; return 0; }
-char* nerd_mcp_send(const char* u, const char* m, const char* p) { (void)u;(void)m;(void)p; return 0; }
-char* nerd_mcp_use(const char* u, const char* t, const char* a) { (void)u;(void)t;(void)a; return 0; }
-char* nerd_mcp_init(const char* url) { (void)url; return 0; }
-char* nerd_mcp_resources(const char* url) { (void)url; return 0; }
-char* nerd_mcp_read(const char* u, const char* uri) { (void)u;(void)uri; return 0; }
-char* nerd_mcp_prompts(const char* url) { (void)url; return 0; }
-char* nerd_mcp_prompt(const char* u, const char* n, const char* a) { (void)u;(void)n;(void)a; return 0; }
-char* nerd_mcp_log(const char* u, const char* l) { (void)u;(void)l; return 0; }
-void nerd_mcp_free(char* ptr) { (void)ptr; }
 
 // ============================================================================
-// LLM Stubs
+// String Interning
 // ============================================================================
+//
+// Maps each distinct string to a small integer id for the current request.
+// The id -> string table points at the map's own key copies.
 
-char* nerd_llm_claude(const char* prompt) { (void)prompt; return 0; }
-void nerd_llm_free(char* ptr) { (void)ptr; }
+static nerd_map* intern_map = 0;
+static nerd_slice* intern_strings = 0;
+static unsigned int intern_count = 0;
+static unsigned int intern_cap = 0;
+static unsigned int* intern_ranks = 0;  // id -> alphabetical position, built on demand
+
+static unsigned int intern_string(nerd_slice s) {
+    if (!intern_map) {
+        intern_map = nerd_map_new(64);
+        intern_cap = 64;
+        intern_strings = (nerd_slice*)wasm_alloc(intern_cap * sizeof(nerd_slice));
+    }
+    unsigned int before = intern_map->size;
+    nerd_map_slot* slot = map_upsert(intern_map, s);
+    if (intern_map->size == before) return (unsigned int)slot->value.number;
+
+    if (intern_count == intern_cap) {
+        nerd_slice* grown = (nerd_slice*)wasm_alloc(intern_cap * 2 * sizeof(nerd_slice));
+        memcpy(grown, intern_strings, intern_cap * sizeof(nerd_slice));
+        wasm_free((char*)intern_strings);
+        intern_strings = grown;
+        intern_cap *= 2;
+    }
+    intern_strings[intern_count] = slot->key;
+    slot->value.number = (double)intern_count;
+    intern_ranks = 0;
+    return intern_count++;
+}
+
+// Case-insensitive order: lower-cased forms first, raw bytes break ties
+static int intern_compare(const nerd_slice* lower, unsigned int a, unsigned int b) {
+    int c = slice_compare(lower[a], lower[b]);
+    return c ? c : slice_compare(intern_strings[a], intern_strings[b]);
+}
+
+// Alphabetical rank of an interned id, ignoring case (utf8_lower) the way the
+// host's localeCompare sorts did. The ranks are computed once per set of ids
+// with an insertion sort; interned sets are small.
+static unsigned int intern_rank(unsigned int id) {
+    if (!intern_ranks) {
+        nerd_slice* lower = (nerd_slice*)wasm_alloc((intern_count + 1) * sizeof(nerd_slice));
+        for (unsigned int i = 0; i < intern_count; i++) {
+            char* copy = wasm_alloc(intern_strings[i].len);
+            memcpy(copy, intern_strings[i].ptr, intern_strings[i].len);
+            utf8_lower(copy, intern_strings[i].len);
+            lower[i] = slice_make(copy, intern_strings[i].len);
+        }
+        unsigned int* order = (unsigned int*)wasm_alloc((intern_count + 1) * sizeof(unsigned int));
+        for (unsigned int i = 0; i < intern_count; i++) {
+            unsigned int j = i;
+            for (; j > 0 && intern_compare(lower, order[j - 1], i) > 0; j--) order[j] = order[j - 1];
+            order[j] = i;
+        }
+        intern_ranks = (unsigned int*)wasm_alloc((intern_count + 1) * sizeof(unsigned int));
+        for (unsigned int k = 0; k < intern_count; k++) intern_ranks[order[k]] = k;
+        wasm_free((char*)order);
+        for (unsigned int i = 0; i < intern_count; i++) wasm_free((char*)lower[i].ptr);
+        wasm_free((char*)lower);
+    }
+    return intern_ranks[id];
+}
 
 // ============================================================================
-// JSON Stubs
+// Number Formatting (Grisu2 shortest round-trip + fixed/precision rounding)
 // ============================================================================
+//
+// dtoa_shortest produces a digit string that always parses back to the same
+// double (Grisu2, after Florian Loitsch / Milo Yip). It is the shortest such
+// string except for a fraction of a percent of 16-17 digit values, where it
+// may emit one extra digit; prices and ratios are unaffected. Fixed and
+// precision formats work from the exact decimal expansion instead (dtoa_exact),
+// like Number#toFixed and C: 1.005 is stored as 1.00499999..., so "%.2f"
+// gives "1.00", and digits past the shortest form are the real ones. True
+// ties round up, as JavaScript does.
 
-char* nerd_json_new(void) { return 0; }
-char* nerd_json_parse(const char* json) { (void)json; return 0; }
-char* nerd_json_get_string(const char* j, const char* p) { (void)j;(void)p; return 0; }
-double nerd_json_get_number(const char* j, const char* p) { (void)j;(void)p; return 0; }
-int nerd_json_get_bool(const char* j, const char* p) { (void)j;(void)p; return 0; }
-char* nerd_json_get_object(const char* j, const char* p) { (void)j;(void)p; return 0; }
-int nerd_json_count(const char* j, const char* p) { (void)j;(void)p; return 0; }
-int nerd_json_has(const char* j, const char* p) { (void)j;(void)p; return 0; }
-void nerd_json_set_string(char* j, const char* p, const char* v) { (void)j;(void)p;(void)v; }
-void nerd_json_set_number(char* j, const char* p, double v) { (void)j;(void)p;(void)v; }
-void nerd_json_set_bool(char* j, const char* p, int v) { (void)j;(void)p;(void)v; }
-char* nerd_json_stringify(const char* json) { (void)json; return 0; }
-void nerd_json_free(char* ptr) { (void)ptr; }
-void nerd_json_free_string(char* ptr) { (void)ptr; }
+typedef unsigned long long u64;
+
+typedef struct diy_fp {
+    u64 f;
+    int e;
+} diy_fp;
+
+#define DP_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFULL
+#define DP_EXPONENT_MASK    0x7FF0000000000000ULL
+#define DP_HIDDEN_BIT       0x0010000000000000ULL
+#define DP_EXPONENT_BIAS    1075
+
+// Normalized 10^k for k = -348, -340, ..., 340
+static const u64 cached_powers_f[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+
+static const short cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066,
+};
+
+static const u64 pow10_u64[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+static u64 double_bits(double d) {
+    union { double d; u64 u; } v;
+    v.d = d;
+    return v.u;
+}
+
+static diy_fp diy_fp_from_double(double d) {
+    u64 bits = double_bits(d);
+    int biased_e = (int)((bits & DP_EXPONENT_MASK) >> 52);
+    diy_fp r;
+    r.f = bits & DP_SIGNIFICAND_MASK;
+    if (biased_e != 0) {
+        r.f += DP_HIDDEN_BIT;
+        r.e = biased_e - DP_EXPONENT_BIAS;
+    } else {
+        r.e = 1 - DP_EXPONENT_BIAS;
+    }
+    return r;
+}
+
+static diy_fp diy_fp_mul(diy_fp x, diy_fp y) {
+    const u64 m32 = 0xFFFFFFFFULL;
+    u64 a = x.f >> 32, b = x.f & m32, c = y.f >> 32, d = y.f & m32;
+    u64 ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    u64 tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+    tmp += 1ULL << 31;  // Round
+    diy_fp r = { ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64 };
+    return r;
+}
+
+static diy_fp diy_fp_normalize(diy_fp x) {
+    while (!(x.f & (1ULL << 63))) { x.f <<= 1; x.e--; }
+    return x;
+}
+
+static void diy_fp_boundaries(diy_fp v, diy_fp* minus, diy_fp* plus) {
+    diy_fp pl = { (v.f << 1) + 1, v.e - 1 };
+    while (!(pl.f & (DP_HIDDEN_BIT << 1))) { pl.f <<= 1; pl.e--; }
+    pl.f <<= 10;  // 64 - 52 - 2
+    pl.e -= 10;
+    diy_fp mi;
+    if (v.f == DP_HIDDEN_BIT) { mi.f = (v.f << 2) - 1; mi.e = v.e - 2; }
+    else { mi.f = (v.f << 1) - 1; mi.e = v.e - 1; }
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+    *minus = mi;
+    *plus = pl;
+}
+
+static diy_fp cached_power(int e, int* k_out) {
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    if (dk - k > 0.0) k++;
+    unsigned int index = (unsigned int)((k >> 3) + 1);
+    *k_out = -(-348 + (int)(index << 3));
+    diy_fp r = { cached_powers_f[index], cached_powers_e[index] };
+    return r;
+}
+
+static void grisu_round(char* buf, int len, u64 delta, u64 rest, u64 ten_kappa, u64 wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int count_digits32(unsigned int n) {
+    int d = 1;
+    while (n >= 10) { n /= 10; d++; }
+    return d;
+}
+
+static void digit_gen(diy_fp w, diy_fp mp, u64 delta, char* buf, int* len, int* k) {
+    diy_fp one = { 1ULL << -mp.e, mp.e };
+    u64 wp_w = mp.f - w.f;
+    unsigned int p1 = (unsigned int)(mp.f >> -one.e);
+    u64 p2 = mp.f & (one.f - 1);
+    int kappa = count_digits32(p1);
+    *len = 0;
+
+    while (kappa > 0) {
+        unsigned int div = (unsigned int)pow10_u64[kappa - 1];
+        unsigned int d = p1 / div;
+        p1 %= div;
+        if (d || *len) buf[(*len)++] = (char)('0' + d);
+        kappa--;
+        u64 tmp = ((u64)p1 << -one.e) + p2;
+        if (tmp <= delta) {
+            *k += kappa;
+            grisu_round(buf, *len, delta, tmp, pow10_u64[kappa] << -one.e, wp_w);
+            return;
+        }
+    }
+
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> -one.e);
+        if (d || *len) buf[(*len)++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *k += kappa;
+            grisu_round(buf, *len, delta, p2, one.f, -kappa < 20 ? wp_w * pow10_u64[-kappa] : 0);
+            return;
+        }
+    }
+}
+
+// Shortest digits of a finite, positive double: value = 0.DIGITS * 10^point.
+// Returns the digit count (at most 17).
+static int dtoa_shortest(double value, char* digits, int* point) {
+    diy_fp v = diy_fp_from_double(value);
+    diy_fp w_m, w_p;
+    diy_fp_boundaries(v, &w_m, &w_p);
+    int k;
+    diy_fp c_mk = cached_power(w_p.e, &k);
+    diy_fp w = diy_fp_mul(diy_fp_normalize(v), c_mk);
+    diy_fp wp = diy_fp_mul(w_p, c_mk);
+    diy_fp wm = diy_fp_mul(w_m, c_mk);
+    wm.f++;
+    wp.f--;
+    int len;
+    digit_gen(w, wp, wp.f - wm.f, digits, &len, &k);
+    *point = len + k;
+    return len;
+}
+
+// Minimal unsigned big integers for dtoa_exact: mant * 5^1074, the widest
+// value it needs, is under 2560 bits.
+#define BIG_LIMBS 84
+
+typedef struct big_uint {
+    unsigned int limb[BIG_LIMBS];
+    int n;
+} big_uint;
+
+static void big_mul_small(big_uint* b, unsigned int m) {
+    u64 carry = 0;
+    for (int i = 0; i < b->n; i++) {
+        u64 t = (u64)b->limb[i] * m + carry;
+        b->limb[i] = (unsigned int)t;
+        carry = t >> 32;
+    }
+    if (carry) b->limb[b->n++] = (unsigned int)carry;
+}
+
+static void big_shl(big_uint* b, int bits) {
+    int words = bits / 32, rem = bits % 32;
+    for (int i = b->n - 1 + words + 1; i >= 0; i--) {
+        u64 hi = i - words < b->n && i - words >= 0 ? (u64)b->limb[i - words] << rem : 0;
+        u64 lo = rem && i - words - 1 >= 0 && i - words - 1 < b->n ? (u64)b->limb[i - words - 1] >> (32 - rem) : 0;
+        b->limb[i] = (unsigned int)(hi | lo);
+    }
+    b->n += words + 1;
+    while (b->n && !b->limb[b->n - 1]) b->n--;
+}
+
+// Divides in place; returns the remainder
+static unsigned int big_divmod_small(big_uint* b, unsigned int d) {
+    u64 rem = 0;
+    for (int i = b->n - 1; i >= 0; i--) {
+        u64 cur = (rem << 32) | b->limb[i];
+        b->limb[i] = (unsigned int)(cur / d);
+        rem = cur % d;
+    }
+    while (b->n && !b->limb[b->n - 1]) b->n--;
+    return (unsigned int)rem;
+}
+
+// Exact decimal expansion of |value| (finite, non-zero), cut to the first
+// `max` significant digits without rounding; trailing zeros dropped. Every
+// double is a finite decimal: mant * 2^e, or mant * 5^-e / 10^-e.
+static int dtoa_exact(double value, char* digits, int max, int* point) {
+    u64 bits = double_bits(value);
+    u64 mant = bits & DP_SIGNIFICAND_MASK;
+    int biased = (int)((bits & DP_EXPONENT_MASK) >> 52);
+    int e2 = biased ? biased - 1075 : -1074;
+    if (biased) mant |= 1ULL << 52;
+
+    big_uint n;
+    n.limb[0] = (unsigned int)mant;
+    n.limb[1] = (unsigned int)(mant >> 32);
+    n.n = n.limb[1] ? 2 : 1;
+    int frac = 0;
+    if (e2 >= 0) {
+        big_shl(&n, e2);
+    } else {
+        frac = -e2;
+        int k = frac;
+        for (; k >= 13; k -= 13) big_mul_small(&n, 1220703125u);  // 5^13
+        while (k--) big_mul_small(&n, 5);
+    }
+
+    // Base 10^9 chunks, least significant first
+    unsigned int chunks[BIG_LIMBS * 32 / 29 + 1];
+    int count = 0;
+    while (n.n) chunks[count++] = big_divmod_small(&n, 1000000000u);
+
+    char top[10];
+    int top_len = 0;
+    for (unsigned int t = chunks[count - 1]; t; t /= 10) top_len++;
+    for (unsigned int t = chunks[count - 1], i = top_len; i > 0; t /= 10) top[--i] = (char)('0' + t % 10);
+    *point = top_len + 9 * (count - 1) - frac;
+    int len = 0;
+    for (int i = 0; i < top_len && len < max; i++) digits[len++] = top[i];
+    for (int c = count - 2; c >= 0 && len < max; c--) {
+        unsigned int chunk = chunks[c];
+        char nine[9];
+        for (int i = 8; i >= 0; i--) { nine[i] = (char)('0' + chunk % 10); chunk /= 10; }
+        for (int i = 0; i < 9 && len < max; i++) digits[len++] = nine[i];
+    }
+    while (len > 1 && digits[len - 1] == '0') len--;
+    return len;
+}
+
+// Round a digit string half-up to `keep` digits (keep may be <= 0).
+// Returns the new length; a carry out of the first digit bumps *point.
+static int round_digits(char* digits, int len, int keep, int* point) {
+    if (keep >= len) return len;
+    if (keep < 0) return 0;
+    int round_up = digits[keep] >= '5';
+    len = keep;
+    if (!round_up) return len;
+    int i = len - 1;
+    while (i >= 0 && digits[i] == '9') { digits[i] = '0'; i--; }
+    if (i >= 0) {
+        digits[i]++;
+    } else {
+        // All nines (or nothing kept): becomes 1 followed by zeros
+        for (int j = len; j > 0; j--) digits[j] = digits[j - 1];
+        digits[0] = '1';
+        len++;
+        (*point)++;
+    }
+    return len;
+}
+
+static int trim_zeros(const char* digits, int len) {
+    while (len > 0 && digits[len - 1] == '0') len--;
+    return len;
+}
+
+static char* put_uint(char* p, unsigned long long n) {
+    char tmp[20];
+    int i = 0;
+    do { tmp[i++] = (char)('0' + n % 10); n /= 10; } while (n);
+    while (i) *p++ = tmp[--i];
+    return p;
+}
+
+// Digits with the decimal point after `point` digits, padded with zeros and
+// cut to `frac` fraction digits (-1: as many as there are digits).
+static char* put_fixed(char* p, const char* digits, int len, int point, int frac) {
+    if (point <= 0) {
+        *p++ = '0';
+    } else {
+        for (int i = 0; i < point; i++) *p++ = i < len ? digits[i] : '0';
+    }
+    if (frac < 0) frac = len > point ? len - point : 0;
+    if (frac > 0) {
+        *p++ = '.';
+        for (int i = 0; i < frac; i++) {
+            int idx = point + i;
+            *p++ = (idx >= 0 && idx < len) ? digits[idx] : '0';
+        }
+    }
+    return p;
+}
+
+// d[.ddd]e±XX; C style pads the exponent to two digits, JS style does not.
+static char* put_exponent(char* p, const char* digits, int len, int exp10, int frac, int c_style) {
+    *p++ = digits[0];
+    if (frac < 0) frac = len - 1;
+    if (frac > 0) {
+        *p++ = '.';
+        for (int i = 1; i <= frac; i++) *p++ = i < len ? digits[i] : '0';
+    }
+    *p++ = 'e';
+    *p++ = exp10 < 0 ? '-' : '+';
+    unsigned int e = (unsigned int)(exp10 < 0 ? -exp10 : exp10);
+    if (c_style && e < 10) *p++ = '0';
+    return put_uint(p, e);
+}
+
+#define NUM_FORMAT_SHORTEST 0  // JS Number#toString rules
+#define NUM_FORMAT_FIXED    1  // %.Nf
+#define NUM_FORMAT_GENERAL  2  // %.Ng
+#define NUM_FORMAT_EXP      3  // %.Ne
+// Worst case is %.100f of DBL_MAX: sign, 309 integer digits, point, 100
+// decimals. The digit buffer shares the size and needs one digit past them.
+#define NUM_BUFFER_SIZE     424
+#define NUM_MAX_PRECISION   100  // Number#toFixed / toPrecision limit
+
+// Formats `value` into `out` (at least NUM_BUFFER_SIZE bytes) and returns the
+// length. Non-finite values print like JavaScript: NaN, Infinity, -Infinity.
+static int format_double(char* out, double value, int mode, int precision, int alt) {
+    char* p = out;
+    u64 bits = double_bits(value);
+    int negative = (int)(bits >> 63);
+    if ((bits & DP_EXPONENT_MASK) == DP_EXPONENT_MASK) {
+        const char* s = (bits & DP_SIGNIFICAND_MASK) ? "NaN" : (negative ? "-Infinity" : "Infinity");
+        while (*s) *p++ = *s++;
+        return (int)(p - out);
+    }
+
+    // Bounded on its own, before it is combined with the exponent, so no
+    // mode can write more than NUM_BUFFER_SIZE bytes
+    if (precision > NUM_MAX_PRECISION) precision = NUM_MAX_PRECISION;
+
+    char digits[NUM_BUFFER_SIZE];
+    int len, point;
+    if (value == 0.0) {
+        digits[0] = '0';
+        len = 1;
+        point = 1;
+        negative = negative && mode != NUM_FORMAT_SHORTEST;  // JS prints -0 as "0"
+    } else if (mode == NUM_FORMAT_SHORTEST) {
+        len = dtoa_shortest(negative ? -value : value, digits, &point);
+    } else {
+        // Precision formats round (and extend) the exact value
+        len = dtoa_exact(value, digits, NUM_BUFFER_SIZE - 8, &point);
+    }
+    if (negative) *p++ = '-';
+
+    if (mode == NUM_FORMAT_SHORTEST) {
+        if (point > 21 || point <= -6) {
+            p = put_exponent(p, digits, len, point - 1, -1, 0);
+        } else {
+            p = put_fixed(p, digits, len, point, -1);
+        }
+    } else if (mode == NUM_FORMAT_FIXED) {
+        // point <= 309, so every precision up to NUM_MAX_PRECISION fits
+        len = value == 0.0 ? len : round_digits(digits, len, point + precision, &point);
+        if (len == 0) { digits[0] = '0'; len = 1; point = 1; }
+        p = put_fixed(p, digits, len, point, precision);
+    } else {
+        int sig = mode == NUM_FORMAT_EXP ? precision + 1 : precision == 0 ? 1 : precision;
+        len = round_digits(digits, len, sig, &point);
+        int exp10 = point - 1;
+        if (mode == NUM_FORMAT_EXP) {
+            p = put_exponent(p, digits, len, exp10, precision, 1);
+        } else if (exp10 < -4 || exp10 >= sig) {
+            if (!alt) len = trim_zeros(digits, len);
+            p = put_exponent(p, digits, len, exp10, alt ? sig - 1 : -1, 1);
+        } else {
+            if (!alt) len = trim_zeros(digits, len);
+            int frac = alt ? sig - 1 - exp10 : (len > point ? len - point : 0);
+            p = put_fixed(p, digits, len, point, frac);
+        }
+    }
+    return (int)(p - out);
+}
+
+// ============================================================================
+// Output Region
+// ============================================================================
+//
+// Everything a render prints is appended to one region of linear memory and
+// handed to the host with js_write only when the region fills up or when the
+// host calls wasm_output_flush at the end of the render. A typical page is a
+// single host crossing.
+
+#define OUTPUT_BUFFER_SIZE 131072
+static char output_buffer[OUTPUT_BUFFER_SIZE];
+static unsigned int output_len = 0;
+static int output_newlines = 0;  // Emit the '\n' of NERD's "%s\n" formats
+static unsigned int output_flush_threshold = 0;  // 0 = only when full or at the end
+
+__attribute__((export_name("wasm_output_flush")))
+void wasm_output_flush(void) {
+    if (output_len) js_write(output_buffer, output_len);
+    output_len = 0;
+}
+
+// Plain-text renders (e.g. /raw) keep one line per `out`; HTML does not.
+__attribute__((export_name("wasm_output_set_newlines")))
+void wasm_output_set_newlines(int enabled) {
+    output_newlines = enabled;
+}
+
+// Streaming renders: flush as soon as `bytes` are pending, and around every
+// print_buffer payload, so the host can forward chunks while Wasm keeps going.
+// Flushes only happen between writes, so a single `out` is never split.
+__attribute__((export_name("wasm_output_set_flush_threshold")))
+void wasm_output_set_flush_threshold(unsigned int bytes) {
+    output_flush_threshold = bytes;
+}
+
+static void out_write(nerd_slice s) {
+    if (s.len > OUTPUT_BUFFER_SIZE - output_len) {
+        wasm_output_flush();
+        // Larger than the whole region: pass it through without copying.
+        if (s.len > OUTPUT_BUFFER_SIZE) {
+            js_write(s.ptr, s.len);
+            return;
+        }
+    }
+    memcpy(output_buffer + output_len, s.ptr, s.len);
+    output_len += s.len;
+    if (output_flush_threshold && output_len >= output_flush_threshold) wasm_output_flush();
+}
+
+static void out_byte(char c) {
+    if (output_len == OUTPUT_BUFFER_SIZE) wasm_output_flush();
+    output_buffer[output_len++] = c;
+}
+
+static void out_line_end(void) {
+    if (output_newlines) out_byte('\n');
+}
+
+#define OUT_LIT(lit) out_write(slice_make(lit, sizeof(lit) - 1))
+
+// ============================================================================
+// Async Host Calls
+// ============================================================================
+//
+// A render that needs data asks for it where the template needs it instead of
+// the host loading everything up front. Before each call that may suspend,
+// the output region goes to the host, so a streaming response already carries
+// the page up to that point while the host waits on KV or the network.
+
+// Unwound frames for asyncify builds (see worker.js); unused under JSPI
+#define ASYNC_STACK_SIZE 16384
+static unsigned int async_stack[ASYNC_STACK_SIZE / sizeof(unsigned int)];
+
+// Resets asyncify's data header ({ next, end }, then the frames) for an unwind
+__attribute__((export_name("wasm_async_stack")))
+unsigned int* wasm_async_stack(void) {
+    async_stack[0] = (unsigned int)(unsigned long)(async_stack + 2);
+    async_stack[1] = (unsigned int)(unsigned long)(async_stack + ASYNC_STACK_SIZE / sizeof(unsigned int));
+    return async_stack;
+}
+
+static void async_call_begin(void) {
+    wasm_output_flush();
+}
+
+// Copies the host's staged result (`len` from the async import) into a
+// NUL-terminated heap block. Null when the host had nothing (-1).
+static char* async_result(int len) {
+    if (len < 0) return 0;
+    char* buf = wasm_alloc((unsigned long)len + 1);
+    js_take_result(buf, (unsigned int)len);
+    buf[len] = 0;
+    return buf;
+}
+
+// ============================================================================
+// Escaping
+// ============================================================================
+//
+// Untrusted fields (titles, slugs, authors, search text) are escaped on their
+// way into the output region. The scan finds the next byte that needs an
+// entity (or a JSON escape) 16 bytes at a time; the clean run before it is
+// copied as is.
+
+enum escape_mode {
+    ESCAPE_TEXT,   // HTML element content: & < >
+    ESCAPE_ATTR,   // quoted HTML attribute value: also " '
+    ESCAPE_XML,    // XML text and attributes (RSS): & < > " '
+    ESCAPE_CDATA,  // inside <![CDATA[ ]]>: only "]]>" is split
+    ESCAPE_JSON,   // JSON string contents: " \ and control characters
+};
+
+static const char* const json_control_escapes[32] = {
+    "\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005", "\\u0006", "\\u0007",
+    "\\b", "\\t", "\\n", "\\u000b", "\\f", "\\r", "\\u000e", "\\u000f",
+    "\\u0010", "\\u0011", "\\u0012", "\\u0013", "\\u0014", "\\u0015", "\\u0016", "\\u0017",
+    "\\u0018", "\\u0019", "\\u001a", "\\u001b", "\\u001c", "\\u001d", "\\u001e", "\\u001f",
+};
+
+static const char* escape_entity(char c, int mode) {
+    if (mode == ESCAPE_JSON) {
+        if ((unsigned char)c < 0x20) return json_control_escapes[(unsigned char)c];
+        return c == '"' ? "\\\"" : c == '\\' ? "\\\\" : 0;
+    }
+    switch (c) {
+        case '&': return "&amp;";
+        case '<': return "&lt;";
+        case '>': return "&gt;";
+        case '"': return mode == ESCAPE_TEXT ? 0 : "&quot;";
+        case '\'': return mode == ESCAPE_TEXT ? 0 : mode == ESCAPE_XML ? "&apos;" : "&#39;";
+    }
+    return 0;
+}
+
+// Length of the leading run of p[0..len) that needs no escaping
+static unsigned int escape_scan(const char* p, unsigned int len, int mode) {
+    unsigned int i = 0;
+#ifdef __wasm_simd128__
+    v128_t amp = wasm_i8x16_splat('&');
+    v128_t lt = wasm_i8x16_splat('<');
+    v128_t gt = wasm_i8x16_splat('>');
+    v128_t quot = wasm_i8x16_splat('"');
+    v128_t apos = wasm_i8x16_splat('\'');
+    v128_t backslash = wasm_i8x16_splat('\\');
+    v128_t space = wasm_i8x16_splat(' ');
+    for (; i + SIMD_WIDTH <= len; i += SIMD_WIDTH) {
+        v128_t v = wasm_v128_load(p + i);
+        v128_t hit;
+        if (mode == ESCAPE_JSON) {
+            hit = wasm_v128_or(wasm_v128_or(wasm_i8x16_eq(v, quot), wasm_i8x16_eq(v, backslash)), wasm_u8x16_lt(v, space));
+        } else {
+            hit = wasm_v128_or(wasm_v128_or(wasm_i8x16_eq(v, amp), wasm_i8x16_eq(v, lt)), wasm_i8x16_eq(v, gt));
+            if (mode != ESCAPE_TEXT) hit = wasm_v128_or(hit, wasm_v128_or(wasm_i8x16_eq(v, quot), wasm_i8x16_eq(v, apos)));
+        }
+        if (wasm_v128_any_true(hit)) return i + __builtin_ctz(wasm_i8x16_bitmask(hit));
+    }
+#endif
+    for (; i < len; i++) {
+        if (escape_entity(p[i], mode)) return i;
+    }
+    return len;
+}
+
+// Escapes `s` into any byte sink: clean runs and entities are passed to
+// `emit` as slices, so the output region and string builders share one scan.
+static void escape_to(nerd_slice s, int mode, void (*emit)(void*, nerd_slice), void* sink) {
+    if (mode == ESCAPE_CDATA) {
+        // "]]>" would end the section early: close it after "]]" and reopen
+        int at;
+        while ((at = mem_find(s.ptr, s.len, "]]>", 3)) >= 0) {
+            emit(sink, slice_make(s.ptr, (unsigned int)at + 2));
+            emit(sink, slice_make("]]><![CDATA[", 12));
+            s = slice_make(s.ptr + at + 2, s.len - (unsigned int)at - 2);
+        }
+        emit(sink, s);
+        return;
+    }
+    unsigned int i = 0;
+    while (i < s.len) {
+        unsigned int run = escape_scan(s.ptr + i, s.len - i, mode);
+        if (run) emit(sink, slice_make(s.ptr + i, run));
+        i += run;
+        if (i < s.len) emit(sink, slice_from_cstr(escape_entity(s.ptr[i++], mode)));
+    }
+}
+
+static void out_emit(void* sink, nerd_slice s) {
+    (void)sink;
+    out_write(s);
+}
+
+static void out_escaped(nerd_slice s, int mode) {
+    escape_to(s, mode, out_emit, 0);
+}
+
+// ============================================================================
+// String Builder
+// ============================================================================
+//
+// Growable byte buffer on the request heap for assembling fragments in Wasm.
+// Capacity doubles when it runs out, so appends are amortized O(1). The
+// result is a slice over the builder's own bytes; nerd_sb_write hands it to
+// the output without another copy when it is large enough to go straight to
+// the host.
+
+// Builders at least this big skip the output region and go to js_write as is
+#define SB_DIRECT_WRITE_MIN 4096
+
+typedef struct nerd_sb {
+    char* data;
+    unsigned int len;
+    unsigned int cap;
+} nerd_sb;
+
+__attribute__((export_name("nerd_sb_new")))
+nerd_sb* nerd_sb_new(unsigned int initial) {
+    nerd_sb* sb = (nerd_sb*)wasm_alloc(sizeof(nerd_sb));
+    sb->cap = initial < 64 ? 64 : initial;
+    sb->data = wasm_alloc(sb->cap);
+    sb->len = 0;
+    return sb;
+}
+
+// Makes room for `extra` more bytes: doubles the capacity, or grows straight
+// to the need when doubling is not enough. Sizes are computed in 64 bits; a
+// need past 4GB can never be met and fails like an out-of-memory wasm_alloc.
+__attribute__((export_name("nerd_sb_reserve")))
+void nerd_sb_reserve(nerd_sb* sb, unsigned int extra) {
+    if (extra <= sb->cap - sb->len) return;
+    u64 need = (u64)sb->len + extra;
+    if (need > 0xFFFFFFFFULL) {
+        stats.failed_allocs++;
+        __builtin_trap();
+    }
+    u64 cap = (u64)sb->cap * 2;
+    if (cap < need || cap > 0xFFFFFFFFULL) cap = need;
+    char* data = wasm_alloc((unsigned long)cap);
+    memcpy(data, sb->data, sb->len);
+    wasm_free(sb->data);
+    sb->data = data;
+    sb->cap = (unsigned int)cap;
+}
+
+__attribute__((export_name("nerd_sb_append")))
+void nerd_sb_append(nerd_sb* sb, const char* ptr, unsigned int len) {
+    nerd_sb_reserve(sb, len);
+    memcpy(sb->data + sb->len, ptr, len);
+    sb->len += len;
+}
+
+__attribute__((export_name("nerd_sb_append_cstr")))
+void nerd_sb_append_cstr(nerd_sb* sb, const char* s) {
+    nerd_sb_append(sb, s, (unsigned int)my_strlen(s));
+}
+
+static void sb_emit(void* sink, nerd_slice s) {
+    nerd_sb_append((nerd_sb*)sink, s.ptr, s.len);
+}
+
+// `mode` is one of enum escape_mode (text, attribute, XML, CDATA, JSON)
+__attribute__((export_name("nerd_sb_append_escaped")))
+void nerd_sb_append_escaped(nerd_sb* sb, const char* ptr, unsigned int len, int mode) {
+    escape_to(slice_make(ptr, len), mode, sb_emit, sb);
+}
+
+// Shortest round-trip form, like JavaScript's String(value)
+__attribute__((export_name("nerd_sb_append_number")))
+void nerd_sb_append_number(nerd_sb* sb, double value) {
+    nerd_sb_reserve(sb, NUM_BUFFER_SIZE);
+    sb->len += (unsigned int)format_double(sb->data + sb->len, value, NUM_FORMAT_SHORTEST, -1, 0);
+}
+
+// The built bytes; valid until the builder grows, is cleared or is freed
+static nerd_slice nerd_sb_slice(const nerd_sb* sb) {
+    return slice_make(sb->data, sb->len);
+}
+
+__attribute__((export_name("nerd_sb_clear")))
+void nerd_sb_clear(nerd_sb* sb) {
+    sb->len = 0;
+}
+
+__attribute__((export_name("nerd_sb_free")))
+void nerd_sb_free(nerd_sb* sb) {
+    wasm_free(sb->data);
+    wasm_free((char*)sb);
+}
+
+// Writes the built bytes to the output. Small fragments are copied into the
+// output region like any `out`; large ones flush it and go to the host
+// directly from the builder's buffer.
+__attribute__((export_name("nerd_sb_write")))
+void nerd_sb_write(const nerd_sb* sb) {
+    nerd_slice s = nerd_sb_slice(sb);
+    if (s.len < SB_DIRECT_WRITE_MIN) {
+        out_write(s);
+        return;
+    }
+    wasm_output_flush();
+    js_write(s.ptr, s.len);
+}
+
+// ============================================================================
+// Data Passing (Shared Buffer)
+// ============================================================================
+//
+// The shared buffer is the per-request input region. The host sizes it for
+// the payload it is about to write (wasm_reserve_shared_buffer), encodes
+// straight into it, and reports the byte length; nothing is NUL-terminated
+// and nothing is cut off. The block comes from the heap, so wasm_reset_heap
+// reclaims it with everything else.
+
+static char* shared_buffer = 0;
+static unsigned int shared_buffer_cap = 0;
+static unsigned int shared_buffer_len = 0;
+
+__attribute__((export_name("wasm_reserve_shared_buffer")))
+char* wasm_reserve_shared_buffer(unsigned int capacity) {
+    if (shared_buffer) wasm_free(shared_buffer);
+    shared_buffer = wasm_alloc(capacity);
+    shared_buffer_cap = capacity;
+    shared_buffer_len = 0;
+    return shared_buffer;
+}
+
+__attribute__((export_name("wasm_get_shared_buffer")))
+char* wasm_get_shared_buffer(void) {
+    return shared_buffer;
+}
+
+// Called by the host after filling the shared buffer. A length beyond the
+// reserved capacity means the host overran it; that is counted and clamped.
+__attribute__((export_name("wasm_set_shared_buffer_len")))
+void wasm_set_shared_buffer_len(unsigned int len) {
+    if (len > shared_buffer_cap) {
+        stats.shared_buffer_truncations++;
+        len = shared_buffer_cap;
+    }
+    if (len > stats.shared_buffer_high_water) stats.shared_buffer_high_water = len;
+    shared_buffer_len = len;
+}
+
+static nerd_slice shared_buffer_slice(void) {
+    return slice_make(shared_buffer, shared_buffer_len);
+}
+
+__attribute__((used))
+double print_buffer(void) {
+    if (output_flush_threshold) wasm_output_flush();
+    out_write(shared_buffer_slice());
+    if (output_flush_threshold) wasm_output_flush();
+    return 0.0;
+}
+
+// ============================================================================
+// CMS Runtime Functions (called by NERD)
+// ============================================================================
+
+// The request path and method are fetched from the host once per request and
+// cached as slices; wasm_reset_heap invalidates them. Values that do not fit
+// the static buffers are fetched again into a heap block of the full length,
+// so routing never sees a truncated path.
+static char request_path_buf[256];
+static nerd_slice request_path = { 0, 0 };
+
+static char request_method_buf[16];
+static nerd_slice request_method = { 0, 0 };
+
+static char request_origin_buf[256];
+static nerd_slice request_origin = { 0, 0 };
+
+static nerd_slice fetch_host_string(int (*fetch)(char*, int), char* buf, int cap) {
+    int len = fetch(buf, cap);
+    if (len < 0) len = 0;
+    if (len > cap - 1) {
+        cap = len + 1;
+        buf = wasm_alloc((unsigned long)cap);
+        len = fetch(buf, cap);
+        if (len < 0) len = 0;
+        if (len > cap - 1) len = cap - 1;  // Host changed its answer; never overrun
+        // May be the first use inside a template arena; the cache outlives it
+        arena_keep_all();
+    }
+    buf[len] = 0;
+    return slice_make(buf, (unsigned int)len);
+}
+
+static nerd_slice cms_path(void) {
+    if (!request_path.ptr) {
+        request_path = fetch_host_string(js_get_request_path, request_path_buf, sizeof(request_path_buf));
+    }
+    return request_path;
+}
+
+static nerd_slice cms_method(void) {
+    if (!request_method.ptr) {
+        request_method = fetch_host_string(js_get_request_method, request_method_buf, sizeof(request_method_buf));
+    }
+    return request_method;
+}
+
+static nerd_slice cms_origin(void) {
+    if (!request_origin.ptr) {
+        request_origin = fetch_host_string(js_get_request_origin, request_origin_buf, sizeof(request_origin_buf));
+    }
+    return request_origin;
+}
+
+// Get request path (NUL-terminated, valid until wasm_reset_heap)
+__attribute__((export_name("nerd_cms_get_path")))
+const char* nerd_cms_get_path(void) {
+    return cms_path().ptr;
+}
+
+// Get request method
+__attribute__((export_name("nerd_cms_get_method")))
+const char* nerd_cms_get_method(void) {
+    return cms_method().ptr;
+}
+
+// Route matching helpers
+__attribute__((export_name("nerd_cms_route_eq")))
+int nerd_cms_route_eq(const char* path) {
+    return slice_eq_cstr(cms_path(), path);
+}
+
+__attribute__((export_name("nerd_cms_route_starts")))
+int nerd_cms_route_starts(const char* prefix) {
+    return slice_starts_with_cstr(cms_path(), prefix);
+}
+
+// Length-aware variants for callers that already know the pattern length
+__attribute__((export_name("nerd_cms_route_eq_n")))
+int nerd_cms_route_eq_n(const char* path, unsigned int len) {
+    return slice_eq(cms_path(), slice_make(path, len));
+}
+
+__attribute__((export_name("nerd_cms_route_starts_n")))
+int nerd_cms_route_starts_n(const char* prefix, unsigned int len) {
+    return slice_starts_with(cms_path(), slice_make(prefix, len));
+}
+
+// ============================================================================
+// Router
+// ============================================================================
+//
+// routes.json is compiled by tools/gen_routes.mjs into the byte trie in
+// routes_gen.h. One walk over the request path picks the route (exact match,
+// else the longest `:param` prefix) and captures the param as a slice of the
+// cached path.
+
+static int route_current = -1;  // -1 until the request is matched
+static nerd_slice route_param_value;
+
+static int route_method_code(nerd_slice method) {
+    for (int m = 1; m < ROUTE_METHOD_COUNT; m++) {
+        if (slice_eq_cstr(method, route_method_names[m])) return m;
+    }
+    return -1;
+}
+
+// First route in refs[start..start+count) that accepts `method`
+static int route_pick(unsigned int start, unsigned int count, int method) {
+    for (unsigned int i = start; i < start + count; i++) {
+        int id = route_trie_refs[i];
+        if (route_methods[id] == ROUTE_METHOD_ANY || route_methods[id] == method) return id;
+    }
+    return ROUTE_NONE;
+}
+
+static int route_match(void) {
+    if (route_current >= 0) return route_current;
+    nerd_slice path = cms_path();
+    int method = route_method_code(cms_method());
+    unsigned int node = 0;
+
+    route_current = ROUTE_NONE;
+    route_param_value = slice_make(0, 0);
+    for (unsigned int i = 0;; i++) {
+        const route_trie_node* n = &route_trie_nodes[node];
+        int id = route_pick(n->param_start, n->param_count, method);
+        if (id) {
+            route_current = id;
+            route_param_value = slice_make(path.ptr + i, path.len - i);
+        }
+        if (i == path.len) {
+            id = route_pick(n->exact_start, n->exact_count, method);
+            if (id) {
+                route_current = id;
+                route_param_value = slice_make(0, 0);
+            }
+            break;
+        }
+        unsigned int e = n->edge_start;
+        unsigned int end = e + n->edge_count;
+        while (e < end && route_trie_edge_byte[e] != (unsigned char)path.ptr[i]) e++;
+        if (e == end) break;
+        node = route_trie_edge_next[e];
+    }
+    return route_current;
+}
+
+// Route id for the current request (ROUTE_NONE if nothing matches)
+__attribute__((export_name("wasm_route")))
+int wasm_route(void) {
+    return route_match();
+}
+
+// The `:param` segment of the matched route, e.g. the slug of /blog/:slug
+__attribute__((export_name("wasm_route_param")))
+const char* wasm_route_param(void) {
+    route_match();
+    return route_param_value.ptr;
+}
+
+__attribute__((export_name("wasm_route_param_len")))
+unsigned int wasm_route_param_len(void) {
+    route_match();
+    return route_param_value.len;
+}
+
+// Runs the route's render_* function if it has one and the program defines
+// it. Returns 0 when the host has to render (or fall back to main) itself.
+__attribute__((export_name("wasm_route_dispatch")))
+int wasm_route_dispatch(void) {
+    double (*render)(void) = route_renders[route_match()];
+    if (!render) return 0;
+    render();
+    return 1;
+}
+
+// ============================================================================
+// Query String
+// ============================================================================
+//
+// The raw query string is fetched from the host once per request, copied into
+// the heap and split into (key, value) slices. Percent-decoding is done in
+// place, so the parsed view points into that single copy, which is kept for
+// the rest of the request even when the first lookup happens in an arena.
+
+#define QUERY_MAX_PARAMS 32
+#define QUERY_INITIAL_SIZE 256
+
+typedef struct nerd_param {
+    nerd_slice key;
+    nerd_slice value;
+} nerd_param;
+
+static nerd_param query_params[QUERY_MAX_PARAMS];
+static unsigned int query_count = 0;
+static int query_parsed = 0;
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// application/x-www-form-urlencoded decoding ('+' and %XX) in place.
+// Malformed escapes are kept as is. Returns the decoded length.
+static unsigned int form_decode(char* p, unsigned int len) {
+    unsigned int w = 0;
+    for (unsigned int r = 0; r < len; r++) {
+        char c = p[r];
+        if (c == '+') {
+            c = ' ';
+        } else if (c == '%' && r + 2 < len && hex_value(p[r + 1]) >= 0 && hex_value(p[r + 2]) >= 0) {
+            c = (char)(hex_value(p[r + 1]) * 16 + hex_value(p[r + 2]));
+            r += 2;
+        }
+        p[w++] = c;
+    }
+    return w;
+}
+
+// Splits "a=1&b=2" into at most `max` params, decoding each key and value in
+// place. Empty segments are skipped, like URLSearchParams.
+static unsigned int form_parse(char* p, unsigned int len, nerd_param* out, unsigned int max) {
+    unsigned int count = 0;
+    unsigned int i = 0;
+    while (i < len && count < max) {
+        unsigned int end = i + mem_find_byte(p + i, len - i, '&');
+        if (end > i) {
+            unsigned int eq = i + mem_find_byte(p + i, end - i, '=');
+            unsigned int value_start = eq < end ? eq + 1 : end;
+            out[count].key = slice_make(p + i, form_decode(p + i, eq - i));
+            out[count].value = slice_make(p + value_start, form_decode(p + value_start, end - value_start));
+            count++;
+        }
+        i = end + 1;
+    }
+    return count;
+}
+
+static void query_parse(void) {
+    if (query_parsed) return;
+    query_parsed = 1;
+    char* buf = wasm_alloc(QUERY_INITIAL_SIZE);
+    int len = js_get_request_query(buf, QUERY_INITIAL_SIZE);
+    if (len >= QUERY_INITIAL_SIZE) {
+        wasm_free(buf);
+        buf = wasm_alloc((unsigned long)len + 1);
+        len = js_get_request_query(buf, len + 1);
+    }
+    if (len < 0) len = 0;
+    query_count = form_parse(buf, (unsigned int)len, query_params, QUERY_MAX_PARAMS);
+    // The first lookup may come from inside a template arena (print_blog_list);
+    // the parsed slices point into `buf` and must outlive it
+    arena_keep_all();
+}
+
+// First value of `name` (empty if absent), like URLSearchParams.get
+static nerd_slice query_get(const char* name) {
+    query_parse();
+    for (unsigned int i = 0; i < query_count; i++) {
+        if (slice_eq_cstr(query_params[i].key, name)) return query_params[i].value;
+    }
+    return slice_make(0, 0);
+}
+
+__attribute__((export_name("nerd_query_count")))
+double nerd_query_count(void) {
+    query_parse();
+    return (double)query_count;
+}
+
+// Attribute-escaped, so it is safe in element content and quoted attributes
+__attribute__((export_name("nerd_query_print")))
+double nerd_query_print(const char* name) {
+    out_escaped(query_get(name), ESCAPE_ATTR);
+    return 0.0;
+}
+
+// ----------------------------------------------------------------------------
+// Query-backed template fragments (NERD cannot pass string arguments yet)
+// ----------------------------------------------------------------------------
+
+// Current search text for the /blog search box
+__attribute__((export_name("print_query_q")))
+double print_query_q(void) {
+    return nerd_query_print("q");
+}
+
+// /blog sort buttons, with the current sort marked active
+__attribute__((export_name("print_sort_tabs")))
+double print_sort_tabs(void) {
+    static const char* const values[] = { "date", "market-cap", "rating" };
+    static const char* const labels[] = { "Date", "Cap", "Rating" };
+    nerd_slice current = query_get("sort");
+    if (!current.len) current = slice_make("date", 4);
+    for (int i = 0; i < 3; i++) {
+        OUT_LIT("<button type=\"submit\" name=\"sort\" value=\"");
+        out_write(slice_from_cstr(values[i]));
+        OUT_LIT("\" class=\"sort-tab ");
+        if (slice_eq_cstr(current, values[i])) OUT_LIT("active");
+        else out_write(slice_from_cstr(values[i]));
+        OUT_LIT("\">");
+        out_write(slice_from_cstr(labels[i]));
+        OUT_LIT("</button>");
+    }
+    return 0.0;
+}
+
+// ============================================================================
+// Post Records (packed binary table written by the host)
+// ============================================================================
+//
+// Layout, all integers little-endian u32:
+//   count, field_count,
+//   count * field_count * (offset, len)   -- offsets relative to the pool
+//   pool                                  -- UTF-8 bytes, no terminators
+// The host writes the table before the render, or the runtime pulls it the
+// first time a template needs it (records_require); NERD templates walk it with
+// nerd_record_next/nerd_record_print or hand the whole loop to a renderer.
+
+// Field order is shared with RECORD_FIELDS in worker.js
+enum record_field {
+    RECORD_SLUG,
+    RECORD_TITLE,
+    RECORD_DATE,
+    RECORD_RATING,
+    RECORD_MARKET_CAP,
+    RECORD_COMPANY_NAME,
+    RECORD_STOCK_PRICE,
+    RECORD_PE_RATIO,
+    RECORD_MARKET_CAP_FORMATTED,
+    RECORD_CATEGORY,
+    RECORD_TAGS,
+    RECORD_EXCERPT,
+    RECORD_PUB_DATE,
+    RECORD_CONTENT_HTML,
+    RECORD_AUTHOR,
+};
+
+static char* records_block = 0;
+static unsigned int records_cap = 0;
+static unsigned int records_count = 0;
+static int records_loaded = 0;  // Written by the host or pulled this request
+static unsigned int records_fields = 0;
+static const unsigned int* records_index = 0;
+static const char* records_pool = 0;
+static int records_cursor = -1;
+
+// Interned fields per record (see "Interned metadata" below)
+enum record_atom {
+    RECORD_ATOM_RATING,
+    RECORD_ATOM_CATEGORY,
+    RECORD_ATOM_FIRST_TAG,
+    RECORD_ATOM_AUTHOR,
+    RECORD_ATOM_COUNT,
+};
+
+static unsigned int* records_atoms = 0;
+
+static void records_intern(void);
+
+__attribute__((export_name("wasm_reserve_records")))
+char* wasm_reserve_records(unsigned int bytes) {
+    if (records_block) wasm_free(records_block);
+    records_block = wasm_alloc(bytes);
+    records_cap = bytes;
+    records_count = 0;
+    return records_block;
+}
+
+// Validates the table the host wrote into the reserved block. Returns the
+// record count, or -1 (and leaves the table empty) if it is malformed.
+__attribute__((export_name("wasm_commit_records")))
+int wasm_commit_records(void) {
+    records_loaded = 1;
+    records_count = 0;
+    records_cursor = -1;
+    if (!records_block || records_cap < 8) return -1;
+    const unsigned int* header = (const unsigned int*)records_block;
+    unsigned long count = header[0], fields = header[1];
+    // Bounded before multiplying: on wasm32 count * fields * 8 can wrap
+    if (fields == 0 || count > (records_cap - 8) / 8 / fields) return -1;
+    unsigned long index_bytes = 8 + count * fields * 8;
+    const unsigned int* index = header + 2;
+    unsigned long pool_size = records_cap - index_bytes;
+    for (unsigned long i = 0; i < count * fields; i++) {
+        unsigned long off = index[i * 2], len = index[i * 2 + 1];
+        if (off > pool_size || len > pool_size - off) return -1;
+    }
+    records_index = index;
+    records_pool = records_block + index_bytes;
+    records_fields = (unsigned int)fields;
+    records_count = (unsigned int)count;
+    records_intern();
+    return (int)count;
+}
+
+// Pulls the table from the host the first time a template needs it, unless
+// the host wrote one before the render. Templates whose branches never reach
+// a record never trigger the KV reads.
+static void records_require(void) {
+    if (records_loaded) return;
+    records_loaded = 1;
+    async_call_begin();
+    int len = js_load_posts();
+    if (len <= 0) return;
+    js_take_result(wasm_reserve_records((unsigned int)len), (unsigned int)len);
+    wasm_commit_records();
+    arena_keep_all();
+}
+
+static nerd_slice record_field(unsigned int rec, unsigned int field) {
+    if (rec >= records_count || field >= records_fields) return slice_make(0, 0);
+    const unsigned int* entry = records_index + (rec * records_fields + field) * 2;
+    return slice_make(records_pool + entry[0], entry[1]);
+}
+
+// ----------------------------------------------------------------------------
+// Interned metadata
+// ----------------------------------------------------------------------------
+//
+// rating, category, first tag and author repeat across posts, so they are
+// interned to small integer ids when the table is committed. Sorting and
+// grouping then compare ids (or the ids' alphabetical ranks) instead of
+// strings. Id 0 is always the empty string.
+
+static nerd_slice record_first_tag(unsigned int rec) {
+    nerd_slice tags = record_field(rec, RECORD_TAGS);
+    return slice_make(tags.ptr, mem_find_byte(tags.ptr, tags.len, ','));
+}
+
+static void records_intern(void) {
+    if (!intern_map) intern_string(slice_make("", 0));
+    records_atoms = (unsigned int*)wasm_alloc((records_count * RECORD_ATOM_COUNT + 1) * sizeof(unsigned int));
+    for (unsigned int rec = 0; rec < records_count; rec++) {
+        unsigned int* atoms = records_atoms + rec * RECORD_ATOM_COUNT;
+        atoms[RECORD_ATOM_RATING] = intern_string(record_field(rec, RECORD_RATING));
+        atoms[RECORD_ATOM_CATEGORY] = intern_string(record_field(rec, RECORD_CATEGORY));
+        atoms[RECORD_ATOM_FIRST_TAG] = intern_string(record_first_tag(rec));
+        atoms[RECORD_ATOM_AUTHOR] = intern_string(record_field(rec, RECORD_AUTHOR));
+    }
+    // Build the ranks now, outside any arena a renderer may push later
+    intern_rank(0);
+}
+
+static unsigned int record_atom(unsigned int rec, int atom) {
+    return records_atoms[rec * RECORD_ATOM_COUNT + atom];
+}
+
+// NERD-facing iterator: `while nerd_record_next` ... `nerd_record_print <field>`
+__attribute__((export_name("nerd_records_count")))
+double nerd_records_count(void) {
+    records_require();
+    return (double)records_count;
+}
+
+__attribute__((export_name("nerd_record_next")))
+double nerd_record_next(void) {
+    records_require();
+    if (records_cursor + 1 >= (int)records_count) return 0.0;
+    records_cursor++;
+    return 1.0;
+}
+
+__attribute__((export_name("nerd_record_rewind")))
+double nerd_record_rewind(void) {
+    records_cursor = -1;
+    return 0.0;
+}
+
+__attribute__((export_name("nerd_record_print")))
+double nerd_record_print(double field) {
+    if (records_cursor < 0) return 0.0;
+    out_write(record_field((unsigned int)records_cursor, (unsigned int)field));
+    return 0.0;
+}
+
+static void print_post_item(unsigned int rec) {
+    nerd_slice company = record_field(rec, RECORD_COMPANY_NAME);
+    nerd_slice price = record_field(rec, RECORD_STOCK_PRICE);
+    nerd_slice pe = record_field(rec, RECORD_PE_RATIO);
+
+    OUT_LIT("<li><a href=\"/blog/");
+    out_escaped(record_field(rec, RECORD_SLUG), ESCAPE_ATTR);
+    OUT_LIT("\">");
+    if (company.len && price.len && pe.len) {
+        // Financial fields present: ultra-high-signal title
+        out_escaped(company, ESCAPE_TEXT);
+        OUT_LIT(" | ");
+        out_escaped(price, ESCAPE_TEXT);
+        OUT_LIT(" | PE: ");
+        out_escaped(pe, ESCAPE_TEXT);
+        OUT_LIT(" | ");
+        out_escaped(record_field(rec, RECORD_MARKET_CAP_FORMATTED), ESCAPE_TEXT);
+    } else {
+        nerd_slice title = record_field(rec, RECORD_TITLE);
+        out_escaped(title.len ? title : record_field(rec, RECORD_SLUG), ESCAPE_TEXT);
+    }
+    OUT_LIT("</a> <span class=\"text-secondary\">(");
+    out_escaped(record_field(rec, RECORD_DATE), ESCAPE_TEXT);
+    OUT_LIT(")</span></li>");
+}
+
+// <li> list for the home page and /blog
+__attribute__((export_name("print_post_list")))
+double print_post_list(void) {
+    records_require();
+    if (output_flush_threshold) wasm_output_flush();
+    for (unsigned int i = 0; i < records_count; i++) print_post_item(i);
+    if (output_flush_threshold) wasm_output_flush();
+    return 0.0;
+}
+
+// parseFloat subset for sort keys: [space][sign]digits[.digits][e[sign]digits].
+// Returns 0 when there is no number, like `parseFloat(x) || 0`.
+static double parse_number(nerd_slice s) {
+    unsigned int i = 0;
+    while (i < s.len && (s.ptr[i] == ' ' || s.ptr[i] == '\t')) i++;
+    double sign = 1.0;
+    if (i < s.len && (s.ptr[i] == '-' || s.ptr[i] == '+')) {
+        if (s.ptr[i] == '-') sign = -1.0;
+        i++;
+    }
+    double value = 0.0;
+    int digits = 0;
+    int exponent = 0;
+    for (; i < s.len && s.ptr[i] >= '0' && s.ptr[i] <= '9'; i++, digits++) value = value * 10.0 + (s.ptr[i] - '0');
+    if (i < s.len && s.ptr[i] == '.') {
+        for (i++; i < s.len && s.ptr[i] >= '0' && s.ptr[i] <= '9'; i++, digits++, exponent--) value = value * 10.0 + (s.ptr[i] - '0');
+    }
+    if (!digits) return 0.0;
+    if (i + 1 < s.len && (s.ptr[i] == 'e' || s.ptr[i] == 'E')) {
+        unsigned int j = i + 1;
+        int exp_sign = 1;
+        if (s.ptr[j] == '-' || s.ptr[j] == '+') exp_sign = s.ptr[j++] == '-' ? -1 : 1;
+        int e = 0;
+        for (; j < s.len && s.ptr[j] >= '0' && s.ptr[j] <= '9'; j++) if (e < 1000) e = e * 10 + (s.ptr[j] - '0');
+        if (j > i + 1 && s.ptr[j - 1] >= '0' && s.ptr[j - 1] <= '9') exponent += exp_sign * e;
+    }
+    for (; exponent > 0; exponent--) value *= 10.0;
+    for (; exponent < 0; exponent++) value /= 10.0;
+    return sign * value;
+}
+
+// ----------------------------------------------------------------------------
+// /blog: search and sort in Wasm
+// ----------------------------------------------------------------------------
+//
+// ?q= keeps posts whose "title-or-slug category tags" text contains q,
+// ignoring case (utf8_lower). ?sort= orders by date (default, newest first),
+// market-cap or rating (highest first), category or first tag (A-Z, ignoring
+// case). The merge sort is stable, so ties keep the host's order.
+
+enum blog_sort {
+    BLOG_SORT_DATE,
+    BLOG_SORT_MARKET_CAP,
+    BLOG_SORT_RATING,
+    BLOG_SORT_CATEGORY,
+    BLOG_SORT_TAG,
+};
+
+static int blog_sort_mode = BLOG_SORT_DATE;
+static double* blog_sort_numbers = 0;  // per record, for the numeric sorts
+static nerd_map* blog_rating_weights = 0;  // 🟢 3, 🟡 2, 🔴 1 (isolate state)
+
+static int blog_compare(unsigned int a, unsigned int b) {
+    switch (blog_sort_mode) {
+        case BLOG_SORT_MARKET_CAP:
+        case BLOG_SORT_RATING:
+            return (blog_sort_numbers[b] > blog_sort_numbers[a]) - (blog_sort_numbers[b] < blog_sort_numbers[a]);
+        case BLOG_SORT_CATEGORY:
+            return (int)intern_rank(record_atom(a, RECORD_ATOM_CATEGORY)) - (int)intern_rank(record_atom(b, RECORD_ATOM_CATEGORY));
+        case BLOG_SORT_TAG:
+            return (int)intern_rank(record_atom(a, RECORD_ATOM_FIRST_TAG)) - (int)intern_rank(record_atom(b, RECORD_ATOM_FIRST_TAG));
+        default:
+            return slice_compare(record_field(b, RECORD_DATE), record_field(a, RECORD_DATE));
+    }
+}
+
+static void blog_sort(unsigned int* idx, unsigned int* tmp, unsigned int n) {
+    if (n < 2) return;
+    unsigned int half = n / 2;
+    blog_sort(idx, tmp, half);
+    blog_sort(idx + half, tmp, n - half);
+    unsigned int i = 0, j = half, k = 0;
+    while (i < half && j < n) tmp[k++] = blog_compare(idx[j], idx[i]) < 0 ? idx[j++] : idx[i++];
+    while (i < half) tmp[k++] = idx[i++];
+    while (j < n) tmp[k++] = idx[j++];
+    memcpy(idx, tmp, n * sizeof(unsigned int));
+}
+
+// Appends `s` to the search text at `dst`; returns the new length
+static unsigned int blog_text_append(char* dst, unsigned int len, nerd_slice s) {
+    memcpy(dst + len, s.ptr, s.len);
+    return len + s.len;
+}
+
+static int blog_matches(unsigned int rec, nerd_slice needle, char* text) {
+    nerd_slice title = record_field(rec, RECORD_TITLE);
+    unsigned int len = blog_text_append(text, 0, title.len ? title : record_field(rec, RECORD_SLUG));
+    text[len++] = ' ';
+    len = blog_text_append(text, len, record_field(rec, RECORD_CATEGORY));
+    text[len++] = ' ';
+    // Tags arrive comma-joined; search them space-separated, as the host did
+    unsigned int tags = len;
+    len = blog_text_append(text, len, record_field(rec, RECORD_TAGS));
+    for (unsigned int i = tags; i < len; i++) if (text[i] == ',') text[i] = ' ';
+    utf8_lower(text, len);
+    return mem_find(text, len, needle.ptr, needle.len) >= 0;
+}
+
+// Filtered, sorted <li> list for /blog. Scratch memory comes from the heap;
+// wrap the call in wasm_arena_push/pop to drop it afterwards.
+__attribute__((export_name("print_blog_list")))
+double print_blog_list(void) {
+    records_require();
+    if (output_flush_threshold) wasm_output_flush();
+    unsigned int n = records_count;
+    unsigned int* idx = (unsigned int*)wasm_alloc((n + 1) * sizeof(unsigned int));
+    unsigned int* tmp = (unsigned int*)wasm_alloc((n + 1) * sizeof(unsigned int));
+
+    // Search: lower-case q once, then scan each record's text
+    nerd_slice q = query_get("q");
+    unsigned int kept = 0;
+    if (q.len) {
+        char* needle = wasm_alloc(q.len);
+        memcpy(needle, q.ptr, q.len);
+        utf8_lower(needle, q.len);
+        unsigned int text_cap = 2;
+        for (unsigned int i = 0; i < n; i++) {
+            unsigned int len = record_field(i, RECORD_TITLE).len + record_field(i, RECORD_SLUG).len +
+                               record_field(i, RECORD_CATEGORY).len + record_field(i, RECORD_TAGS).len + 2;
+            if (len > text_cap) text_cap = len;
+        }
+        char* text = wasm_alloc(text_cap);
+        for (unsigned int i = 0; i < n; i++) {
+            if (blog_matches(i, slice_make(needle, q.len), text)) idx[kept++] = i;
+        }
+    } else {
+        for (unsigned int i = 0; i < n; i++) idx[kept++] = i;
+    }
+
+    nerd_slice sort = query_get("sort");
+    blog_sort_mode = BLOG_SORT_DATE;
+    if (slice_eq_cstr(sort, "market-cap")) blog_sort_mode = BLOG_SORT_MARKET_CAP;
+    else if (slice_eq_cstr(sort, "rating")) blog_sort_mode = BLOG_SORT_RATING;
+    else if (slice_eq_cstr(sort, "category")) blog_sort_mode = BLOG_SORT_CATEGORY;
+    else if (slice_eq_cstr(sort, "tag")) blog_sort_mode = BLOG_SORT_TAG;
+
+    if (blog_sort_mode == BLOG_SORT_MARKET_CAP || blog_sort_mode == BLOG_SORT_RATING) {
+        blog_sort_numbers = (double*)wasm_alloc((n + 1) * sizeof(double));
+        double* weight_by_id = 0;
+        if (blog_sort_mode == BLOG_SORT_RATING) {
+            // One map lookup per distinct rating, then per-record array reads
+            nerd_map* weights = blog_rating_weights;
+            weight_by_id = (double*)wasm_alloc((intern_count + 1) * sizeof(double));
+            for (unsigned int id = 0; id < intern_count; id++) {
+                weight_by_id[id] = nerd_map_get_number(weights, intern_strings[id].ptr, intern_strings[id].len, 0.0);
+            }
+        }
+        for (unsigned int i = 0; i < n; i++) {
+            blog_sort_numbers[i] = weight_by_id ? weight_by_id[record_atom(i, RECORD_ATOM_RATING)]
+                                                : parse_number(record_field(i, RECORD_MARKET_CAP));
+        }
+    }
+    blog_sort(idx, tmp, kept);
+
+    for (unsigned int k = 0; k < kept; k++) print_post_item(idx[k]);
+    blog_sort_numbers = 0;
+    if (output_flush_threshold) wasm_output_flush();
+    return 0.0;
+}
+
+static void print_rss_item(unsigned int rec) {
+    nerd_slice origin = cms_origin();
+    nerd_slice slug = record_field(rec, RECORD_SLUG);
+    OUT_LIT("<item><title>");
+    out_escaped(record_field(rec, RECORD_TITLE), ESCAPE_XML);
+    OUT_LIT("</title><link>");
+    out_escaped(origin, ESCAPE_XML);
+    OUT_LIT("/blog/");
+    out_escaped(slug, ESCAPE_XML);
+    OUT_LIT("</link><guid>");
+    out_escaped(origin, ESCAPE_XML);
+    OUT_LIT("/blog/");
+    out_escaped(slug, ESCAPE_XML);
+    OUT_LIT("</guid><description>");
+    out_escaped(record_field(rec, RECORD_EXCERPT), ESCAPE_XML);
+    OUT_LIT("</description><content:encoded><![CDATA[");
+    out_escaped(record_field(rec, RECORD_CONTENT_HTML), ESCAPE_CDATA);
+    OUT_LIT("]]></content:encoded><pubDate>");
+    out_escaped(record_field(rec, RECORD_PUB_DATE), ESCAPE_XML);
+    OUT_LIT("</pubDate></item>");
+}
+
+// <item> elements for /rss.xml (AI-friendly, with full content)
+__attribute__((export_name("print_rss_items")))
+double print_rss_items(void) {
+    records_require();
+    if (output_flush_threshold) wasm_output_flush();
+    for (unsigned int i = 0; i < records_count; i++) print_rss_item(i);
+    if (output_flush_threshold) wasm_output_flush();
+    return 0.0;
+}
+
+// ============================================================================
+// Named Input Slots
+// ============================================================================
+//
+// Small per-request key/value table the host fills by reference: one block
+// holding u32 count, count * (name_off, name_len, value_off, value_len), then
+// a UTF-8 pool. Templates read fields by name (title, body_html, q, ...)
+// instead of the host concatenating them into one blob.
+
+#define MAX_SLOTS 32
+
+typedef struct nerd_slot_entry {
+    nerd_slice name;
+    nerd_slice value;
+} nerd_slot_entry;
+
+static char* slots_block = 0;
+static unsigned int slots_cap = 0;
+static nerd_slot_entry slots[MAX_SLOTS];
+static unsigned int slots_count = 0;
+
+__attribute__((export_name("wasm_reserve_slots")))
+char* wasm_reserve_slots(unsigned int bytes) {
+    if (slots_block) wasm_free(slots_block);
+    slots_block = wasm_alloc(bytes);
+    slots_cap = bytes;
+    slots_count = 0;
+    return slots_block;
+}
+
+// Returns the slot count, or -1 (and no slots) if the table is malformed.
+__attribute__((export_name("wasm_commit_slots")))
+int wasm_commit_slots(void) {
+    slots_count = 0;
+    if (!slots_block || slots_cap < 4) return -1;
+    const unsigned int* header = (const unsigned int*)slots_block;
+    unsigned long count = header[0];
+    unsigned long index_bytes = 4 + count * 16;
+    if (count > MAX_SLOTS || index_bytes > slots_cap) return -1;
+    const char* pool = slots_block + index_bytes;
+    unsigned long pool_size = slots_cap - index_bytes;
+    for (unsigned long i = 0; i < count; i++) {
+        const unsigned int* e = header + 1 + i * 4;
+        if (e[0] > pool_size || e[1] > pool_size - e[0]) return -1;
+        if (e[2] > pool_size || e[3] > pool_size - e[2]) return -1;
+        slots[i].name = slice_make(pool + e[0], e[1]);
+        slots[i].value = slice_make(pool + e[2], e[3]);
+    }
+    slots_count = (unsigned int)count;
+    return (int)count;
+}
+
+// Empty slice when the slot is missing
+static nerd_slice slot(const char* name) {
+    for (unsigned int i = 0; i < slots_count; i++) {
+        if (slice_eq_cstr(slots[i].name, name)) return slots[i].value;
+    }
+    return slice_make(0, 0);
+}
+
+__attribute__((export_name("nerd_slot_print")))
+double nerd_slot_print(const char* name) {
+    out_write(slot(name));
+    return 0.0;
+}
+
+// ----------------------------------------------------------------------------
+// Slot-backed template fragments (NERD cannot pass string arguments yet)
+// ----------------------------------------------------------------------------
+
+// Post page header: title (or upper-cased slug), author, date and rating,
+// assembled in a builder and written as one fragment
+__attribute__((export_name("print_post_header")))
+double print_post_header(void) {
+    nerd_slice title = slot("title");
+    nerd_slice author = slot("author");
+    nerd_slice rating = slot("rating");
+    nerd_sb* sb = nerd_sb_new(256);
+
+    nerd_sb_append_cstr(sb, "<header class=\"post-header\"><h1>");
+    if (title.len) {
+        nerd_sb_append_escaped(sb, title.ptr, title.len, ESCAPE_TEXT);
+    } else {
+        nerd_slice slug = slot("slug");
+        unsigned int start = sb->len;
+        nerd_sb_append_escaped(sb, slug.ptr, slug.len, ESCAPE_TEXT);
+        // Upper-case outside entities only ("&amp;" must stay lower-case)
+        for (unsigned int i = start, in_entity = 0; i < sb->len; i++) {
+            char c = sb->data[i];
+            if (c == '&') in_entity = 1;
+            else if (c == ';') in_entity = 0;
+            else if (!in_entity && c >= 'a' && c <= 'z') sb->data[i] = (char)(c - 32);
+        }
+    }
+    nerd_sb_append_cstr(sb, "</h1><div class=\"post-meta\">");
+    if (author.len) nerd_sb_append_escaped(sb, author.ptr, author.len, ESCAPE_TEXT);
+    else nerd_sb_append_cstr(sb, "Anonymous");
+    nerd_sb_append_cstr(sb, " · ");
+    nerd_slice date = slot("date");
+    nerd_sb_append_escaped(sb, date.ptr, date.len, ESCAPE_TEXT);
+    if (rating.len) {
+        nerd_sb_append_cstr(sb, " <span class=\"post-rating\" style=\"font-size: 1.5rem; margin-left: 10px;\">");
+        nerd_sb_append_escaped(sb, rating.ptr, rating.len, ESCAPE_TEXT);
+        nerd_sb_append_cstr(sb, "</span>");
+    }
+    nerd_sb_append_cstr(sb, "</div></header>");
+
+    nerd_sb_write(sb);
+    nerd_sb_free(sb);
+    return 0.0;
+}
+
+// Post page body: pre-rendered article HTML
+__attribute__((export_name("print_post_body")))
+double print_post_body(void) {
+    OUT_LIT("<div class=\"post-content\">");
+    out_write(slot("body_html"));
+    OUT_LIT("</div>");
+    return 0.0;
+}
+
+// ============================================================================
+// printf / puts Implementations (NERD uses printf for 'out')
+// ============================================================================
+//
+// A small printf that formats straight into the output region. Supported:
+// %s %c %d %i %u %x %f %e %g %%, flags "-+ 0#", width and precision (both
+// also as '*'), and the l/ll/h/z length modifiers. "%g" without a precision
+// prints the shortest round-trip form (3100.5, 0.1, 1e+21), matching how
+// JavaScript prints numbers; "%.Ng" follows C. A '\n' at the very end of the
+// format is NERD's line terminator and is only emitted in newline mode.
+
+// The LLVM optimizer may convert printf("%s\n", str) to puts(str)
+int puts(const char* str) {
+    out_write(slice_from_cstr(str));
+    out_line_end();
+    return 0;
+}
+
+static void out_padding(char c, int n) {
+    while (n-- > 0) out_byte(c);
+}
+
+// Writes sign/prefix + body with width padding. Zero padding goes between
+// the sign and the digits.
+// printf integer precision: at least `precision` digits in [start, end),
+// zero-filled on the left, and no digits for a zero value at precision 0.
+// Returns the new end; `start` has room for NUM_BUFFER_SIZE digits.
+static char* put_int_precision(char* start, char* end, int precision, int is_zero) {
+    if (precision < 0) return end;
+    if (precision == 0 && is_zero) return start;
+    if (precision > NUM_BUFFER_SIZE) precision = NUM_BUFFER_SIZE;
+    int n = (int)(end - start);
+    if (n >= precision) return end;
+    int pad = precision - n;
+    for (int i = n - 1; i >= 0; i--) start[i + pad] = start[i];
+    for (int i = 0; i < pad; i++) start[i] = '0';
+    return start + precision;
+}
+
+static void out_padded(const char* body, int len, int width, int left, int zero) {
+    int pad = width > len ? width - len : 0;
+    if (left) {
+        out_write(slice_make(body, (unsigned int)len));
+        out_padding(' ', pad);
+    } else if (zero) {
+        int sign = len > 0 && (body[0] == '-' || body[0] == '+' || body[0] == ' ');
+        if (sign) out_byte(body[0]);
+        out_padding('0', pad);
+        out_write(slice_make(body + sign, (unsigned int)(len - sign)));
+    } else {
+        out_padding(' ', pad);
+        out_write(slice_make(body, (unsigned int)len));
+    }
+}
+
+int printf(const char* fmt, ...) {
+    __builtin_va_list args;
+    __builtin_va_start(args, fmt);
+
+    const char* p = fmt;
+    while (*p) {
+        // Copy the literal run up to the next conversion in one write
+        const char* run = p;
+        while (*p && *p != '%') p++;
+        if (p > run) {
+            unsigned int n = (unsigned int)(p - run);
+            int line_end = !*p && run[n - 1] == '\n';
+            out_write(slice_make(run, line_end ? n - 1 : n));
+            if (line_end) out_line_end();
+        }
+        if (!*p) break;
+        p++;  // '%'
+
+        int left = 0, plus = 0, space = 0, zero = 0, alt = 0;
+        for (;; p++) {
+            if (*p == '-') left = 1;
+            else if (*p == '+') plus = 1;
+            else if (*p == ' ') space = 1;
+            else if (*p == '0') zero = 1;
+            else if (*p == '#') alt = 1;
+            else break;
+        }
+        int width = 0;
+        if (*p == '*') {
+            width = __builtin_va_arg(args, int);
+            if (width < 0) { left = 1; width = -width; }
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') width = width * 10 + (*p++ - '0');
+        }
+        int precision = -1;
+        if (*p == '.') {
+            p++;
+            precision = 0;
+            if (*p == '*') {
+                precision = __builtin_va_arg(args, int);
+                if (precision < 0) precision = -1;  // Negative: as if omitted
+                p++;
+            } else {
+                while (*p >= '0' && *p <= '9') precision = precision * 10 + (*p++ - '0');
+            }
+        }
+        int longs = 0;  // Count of 'l' modifiers; h and z are int-sized here
+        while (*p == 'l' || *p == 'h' || *p == 'z') {
+            if (*p == 'l') longs++;
+            p++;
+        }
+
+        char buf[NUM_BUFFER_SIZE + 8];
+        char* b = buf;
+        char conv = *p ? *p++ : 0;
+        switch (conv) {
+        case 's': {
+            const char* str = __builtin_va_arg(args, const char*);
+            if (!str) str = "(null)";
+            unsigned int n = 0;
+            while (str[n] && (precision < 0 || n < (unsigned int)precision)) n++;
+            out_padded(str, (int)n, width, left, 0);
+            continue;
+        }
+        case 'c':
+            buf[0] = (char)__builtin_va_arg(args, int);
+            out_padded(buf, 1, width, left, 0);
+            continue;
+        case '%':
+            out_byte('%');
+            continue;
+        case 'd': case 'i': {
+            long long v = longs >= 2 ? __builtin_va_arg(args, long long)
+                        : longs == 1 ? __builtin_va_arg(args, long) : __builtin_va_arg(args, int);
+            unsigned long long mag = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+            if (v < 0) *b++ = '-';
+            else if (plus) *b++ = '+';
+            else if (space) *b++ = ' ';
+            b = put_int_precision(b, put_uint(b, mag), precision, mag == 0);
+            out_padded(buf, (int)(b - buf), width, left, zero && precision < 0);
+            continue;
+        }
+        case 'u': case 'x': {
+            unsigned long long v = longs >= 2 ? __builtin_va_arg(args, unsigned long long)
+                                 : longs == 1 ? __builtin_va_arg(args, unsigned long)
+                                 : __builtin_va_arg(args, unsigned int);
+            int is_zero = v == 0;
+            if (conv == 'u') {
+                b = put_uint(b, v);
+            } else {
+                char tmp[16];
+                int n = 0;
+                do { tmp[n++] = "0123456789abcdef"[v & 15]; v >>= 4; } while (v);
+                while (n) *b++ = tmp[--n];
+            }
+            b = put_int_precision(buf, b, precision, is_zero);
+            out_padded(buf, (int)(b - buf), width, left, zero && precision < 0);
+            continue;
+        }
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+            double v = __builtin_va_arg(args, double);
+            int mode;
+            if (conv == 'f' || conv == 'F') { mode = NUM_FORMAT_FIXED; if (precision < 0) precision = 6; }
+            else if (conv == 'e' || conv == 'E') { mode = NUM_FORMAT_EXP; if (precision < 0) precision = 6; }
+            else mode = precision < 0 ? NUM_FORMAT_SHORTEST : NUM_FORMAT_GENERAL;
+            if (!(double_bits(v) >> 63)) {
+                if (plus) *b++ = '+';
+                else if (space) *b++ = ' ';
+            }
+            b += format_double(b, v, mode, precision, alt);
+            // NaN and Infinity are space-padded even with the 0 flag
+            int finite = (double_bits(v) & DP_EXPONENT_MASK) != DP_EXPONENT_MASK;
+            out_padded(buf, (int)(b - buf), width, left, zero && finite);
+            continue;
+        }
+        default:
+            // Unknown conversion: print it verbatim
+            out_byte('%');
+            if (conv) out_byte(conv);
+            continue;
+        }
+    }
+
+    __builtin_va_end(args);
+    return 0;
+}
+
+// ============================================================================
+// HTTP and KV (async host calls)
+// ============================================================================
+//
+// Results are NUL-terminated heap blocks (free with nerd_http_free, or leave
+// them to wasm_reset_heap); null when the request failed. Header arguments
+// are "Name: value" lines separated by '\n'.
+
+#define JSON_HEADERS "Content-Type: application/json\nAccept: application/json"
+
+static char* http_call(const char* method, const char* url, unsigned int url_len,
+                       const char* headers, const char* body, unsigned int body_len) {
+    if (!url) return 0;
+    if (!method) method = "GET";
+    async_call_begin();
+    return async_result(js_http_fetch(method, strlen(method), url, url_len,
+                                      headers, headers ? strlen(headers) : 0, body, body_len));
+}
+
+static unsigned int str_len(const char* s) {
+    return s ? strlen(s) : 0;
+}
+
+char* nerd_http_get(const char* url) { return http_call("GET", url, str_len(url), 0, 0, 0); }
+char* nerd_http_post(const char* url, const char* body) { return http_call("POST", url, str_len(url), 0, body, str_len(body)); }
+void nerd_http_free(char* ptr) { wasm_free(ptr); }
+char* nerd_http_get_json(const char* url) { return http_call("GET", url, str_len(url), "Accept: application/json", 0, 0); }
+char* nerd_http_post_json(const char* url, const char* body) { return http_call("POST", url, str_len(url), JSON_HEADERS, body, str_len(body)); }
+char* nerd_http_post_json_body(const char* url, const char* body) { return nerd_http_post_json(url, body); }
+char* nerd_http_request(const char* m, const char* u, const char* h, const char* b) { return http_call(m, u, str_len(u), h, b, str_len(b)); }
+char* nerd_http_get_full(const char* url, const char* h) { return http_call("GET", url, str_len(url), h, 0, 0); }
+char* nerd_http_post_full(const char* u, const char* b, const char* h) { return http_call("POST", u, str_len(u), h, b, str_len(b)); }
+char* nerd_http_put(const char* u, const char* b, const char* h) { return http_call("PUT", u, str_len(u), h, b, str_len(b)); }
+char* nerd_http_delete(const char* u, const char* h) { return http_call("DELETE", u, str_len(u), h, 0, 0); }
+char* nerd_http_patch(const char* u, const char* b, const char* h) { return http_call("PATCH", u, str_len(u), h, b, str_len(b)); }
+
+static const char base64_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// "Authorization: <scheme> " followed by `a`, or by base64("a:b") when b is given
+static char* auth_header(const char* scheme, const char* a, const char* b) {
+    // Only the buffer outlives the call, so the builder lives on the stack
+    nerd_sb builder = { wasm_alloc(64), 0, 64 };
+    nerd_sb* sb = &builder;
+    nerd_sb_append_cstr(sb, "Authorization: ");
+    nerd_sb_append_cstr(sb, scheme);
+    nerd_sb_append_cstr(sb, " ");
+    if (!b) {
+        if (a) nerd_sb_append_cstr(sb, a);
+    } else {
+        unsigned int alen = str_len(a), blen = strlen(b), n = alen + 1 + blen;
+        char* raw = wasm_alloc(n);
+        memcpy(raw, a, alen);
+        raw[alen] = ':';
+        memcpy(raw + alen + 1, b, blen);
+        for (unsigned int i = 0; i < n; i += 3) {
+            unsigned int v = (unsigned char)raw[i] << 16;
+            if (i + 1 < n) v |= (unsigned char)raw[i + 1] << 8;
+            if (i + 2 < n) v |= (unsigned char)raw[i + 2];
+            char quad[4] = {
+                base64_digits[v >> 18], base64_digits[(v >> 12) & 63],
+                i + 1 < n ? base64_digits[(v >> 6) & 63] : '=',
+                i + 2 < n ? base64_digits[v & 63] : '=',
+            };
+            nerd_sb_append(sb, quad, 4);
+        }
+        wasm_free(raw);
+    }
+    nerd_sb_append(sb, "", 1);
+    return sb->data;
+}
+
+char* nerd_http_auth_bearer(const char* t) { return auth_header("Bearer", t, 0); }
+char* nerd_http_auth_basic(const char* u, const char* p) { return auth_header("Basic", u, p ? p : ""); }
+
+// Length-aware variants: (ptr, len) pairs instead of NUL-terminated strings
+char* nerd_http_get_n(const char* url, unsigned int url_len) { return http_call("GET", url, url_len, 0, 0, 0); }
+char* nerd_http_post_n(const char* url, unsigned int url_len, const char* body, unsigned int body_len) { return http_call("POST", url, url_len, 0, body, body_len); }
+
+// Value stored under `key` in the site's KV namespace, or null
+char* nerd_kv_get(const char* key) {
+    if (!key) return 0;
+    async_call_begin();
+    return async_result(js_kv_get(key, strlen(key)));
+}
+
+char* nerd_kv_get_n(const char* key, unsigned int key_len) {
+    async_call_begin();
+    return async_result(js_kv_get(key, key_len));
+}
+
+// ============================================================================
+// MCP Stubs
+// ============================================================================
+
+char* nerd_mcp_list(const char* url) { (void)url; return 0; }
+char* nerd_mcp_send(const char* u, const char* m, const char* p) { (void)u;(void)m;(void)p; return 0; }
+char* nerd_mcp_use(const char* u, const char* t, const char* a) { (void)u;(void)t;(void)a; return 0; }
+char* nerd_mcp_init(const char* url) { (void)url; return 0; }
+char* nerd_mcp_resources(const char* url) { (void)url; return 0; }
+char* nerd_mcp_read(const char* u, const char* uri) { (void)u;(void)uri; return 0; }
+char* nerd_mcp_prompts(const char* url) { (void)url; return 0; }
+char* nerd_mcp_prompt(const char* u, const char* n, const char* a) { (void)u;(void)n;(void)a; return 0; }
+char* nerd_mcp_log(const char* u, const char* l) { (void)u;(void)l; return 0; }
+void nerd_mcp_free(char* ptr) { (void)ptr; }
+
+// ============================================================================
+// LLM Stubs
+// ============================================================================
+
+char* nerd_llm_claude(const char* prompt) { (void)prompt; return 0; }
+void nerd_llm_free(char* ptr) { (void)ptr; }
+
+// ============================================================================
+// JSON
+// ============================================================================
+//
+// Two-stage parser in the style of simdjson. Stage 1 classifies the input 16
+// bytes at a time and writes the offset of every structural byte outside
+// strings ({ } [ ] : ,), every unescaped quote and the first byte of every
+// number/literal to an index, and rejects raw control characters inside
+// strings. Stage 2 walks that index once, validates the grammar and every
+// string's escapes, and records the document on a flat tape of 64-bit words:
+//
+//   '{' / '['   payload = tape index after the matching close | count << 32
+//   '}' / ']'   payload = tape index of the matching open
+//   '"'         payload = offset of the first byte; next word = byte length
+//   'd'         next word = the double's bits
+//   't' 'f' 'n'
+//
+// The parser keeps a padded copy of the input (SIMD loads may run past the
+// end), and strings are slices of that copy: they are unescaped and
+// NUL-terminated in place the first time they are read, so a lookup such as
+// nerd_json_get_string(j, "a.b[2]") returns a pointer into the document
+// without allocating. Everything lives on the request heap.
+
+#define JSON_BLOCK 16
+#define JSON_MAX_DEPTH 256
+#define JSON_MAX_COUNT 0xFFFFFF
+#define JSON_STRING_DECODED (1ull << 63)
+
+typedef struct json_node json_node;
+
+typedef struct nerd_json {
+    char* buf;          // padded copy of the input
+    u64* tape;
+    unsigned int root;  // tape index of this handle's value
+    int is_view;        // borrowed from another document (nerd_json_get_object)
+    json_node* tree;    // nerd_json_new documents: built with nerd_json_set_*
+} nerd_json;
+
+static u64 json_word(char type, u64 payload) {
+    return ((u64)(unsigned char)type << 56) | payload;
+}
+
+static char json_type(const nerd_json* j, unsigned int at) {
+    return (char)(j->tape[at] >> 56);
+}
+
+static unsigned int json_payload(const nerd_json* j, unsigned int at) {
+    return (unsigned int)j->tape[at];
+}
+
+// ----------------------------------------------------------------------------
+// Stage 1: structural index
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    unsigned int quote;
+    unsigned int backslash;
+    unsigned int op;     // { } [ ] : ,
+    unsigned int space;  // space \t \n \r
+    unsigned int control;  // bytes below 0x20
+} json_block;
+
+static json_block json_classify(const char* p) {
+    json_block b;
+#ifdef __wasm_simd128__
+    v128_t v = wasm_v128_load(p);
+    // OR-ing 0x20 folds '[' and ']' onto '{' and '}'; ':' and ',' keep their value
+    v128_t folded = wasm_v128_or(v, wasm_i8x16_splat(0x20));
+    b.quote = wasm_i8x16_bitmask(wasm_i8x16_eq(v, wasm_i8x16_splat('"')));
+    b.backslash = wasm_i8x16_bitmask(wasm_i8x16_eq(v, wasm_i8x16_splat('\\')));
+    b.op = wasm_i8x16_bitmask(wasm_v128_or(
+        wasm_v128_or(wasm_i8x16_eq(folded, wasm_i8x16_splat('{')), wasm_i8x16_eq(folded, wasm_i8x16_splat('}'))),
+        wasm_v128_or(wasm_i8x16_eq(v, wasm_i8x16_splat(':')), wasm_i8x16_eq(v, wasm_i8x16_splat(',')))));
+    b.space = wasm_i8x16_bitmask(wasm_v128_or(
+        wasm_v128_or(wasm_i8x16_eq(v, wasm_i8x16_splat(' ')), wasm_i8x16_eq(v, wasm_i8x16_splat('\t'))),
+        wasm_v128_or(wasm_i8x16_eq(v, wasm_i8x16_splat('\n')), wasm_i8x16_eq(v, wasm_i8x16_splat('\r')))));
+    b.control = wasm_i8x16_bitmask(wasm_u8x16_lt(v, wasm_i8x16_splat(0x20)));
+#else
+    b.quote = b.backslash = b.op = b.space = b.control = 0;
+    for (unsigned int i = 0; i < JSON_BLOCK; i++) {
+        char c = p[i];
+        unsigned int bit = 1u << i;
+        if (c == '"') b.quote |= bit;
+        else if (c == '\\') b.backslash |= bit;
+        else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') b.op |= bit;
+        else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') b.space |= bit;
+        if ((unsigned char)c < 0x20) b.control |= bit;
+    }
+#endif
+    return b;
+}
+
+// Bit i set when an odd number of quote bits are at or below i
+static unsigned int json_prefix_xor(unsigned int x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    return x & 0xFFFF;
+}
+
+// Index the structurals of buf[0..padded_len) (a multiple of JSON_BLOCK).
+// Returns the count, or -1 if a string is left open or holds a raw control
+// character.
+static int json_index(const char* buf, unsigned int padded_len, unsigned int* index) {
+    unsigned int count = 0;
+    unsigned int in_string = 0;    // 0xFFFF when the block starts inside a string
+    unsigned int escape_next = 0;  // the block's first byte is escaped
+    unsigned int prev_atom = 0;    // the previous block ended inside an atom
+    for (unsigned int base = 0; base < padded_len; base += JSON_BLOCK) {
+        json_block b = json_classify(buf + base);
+
+        unsigned int escaped = 0;
+        if (b.backslash | escape_next) {
+            for (unsigned int i = 0; i < JSON_BLOCK; i++) {
+                if (escape_next) {
+                    escaped |= 1u << i;
+                    escape_next = 0;
+                } else if (b.backslash & (1u << i)) {
+                    escape_next = 1;
+                }
+            }
+        }
+
+        // Opening quotes and string contents are "inside"; closing quotes are not
+        unsigned int quote = b.quote & ~escaped;
+        unsigned int inside = json_prefix_xor(quote) ^ in_string;
+        in_string = (inside & 0x8000) ? 0xFFFF : 0;
+        if (b.control & inside) return -1;
+
+        unsigned int atom = ~(b.quote | b.op | b.space | inside) & 0xFFFF;
+        unsigned int atom_start = atom & ~((atom << 1) | prev_atom);
+        prev_atom = atom >> 15;
+
+        unsigned int mask = (b.op & ~inside) | quote | atom_start;
+        while (mask) {
+            index[count++] = base + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    return in_string ? -1 : (int)count;
+}
+
+// ----------------------------------------------------------------------------
+// Stage 2: tape
+// ----------------------------------------------------------------------------
+
+static const double json_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static int json_is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// mantissa * 10^exponent through the Grisu cached powers: the 64-bit
+// product is within a couple of units of the exact value, so only inputs
+// within that distance of a rounding boundary can come out one ulp off.
+static double json_scale(u64 mantissa, int exponent) {
+    if (exponent < -348) return 0.0;
+    if (exponent > 340) return 1.0 / 0.0;
+    int k = (exponent + 348) / 8;
+    int rest = (exponent + 348) % 8;
+    diy_fp v = diy_fp_normalize((diy_fp){ mantissa, 0 });
+    if (rest) v = diy_fp_normalize(diy_fp_mul(v, diy_fp_normalize((diy_fp){ pow10_u64[rest], 0 })));
+    diy_fp power = { cached_powers_f[k], cached_powers_e[k] };
+    v = diy_fp_normalize(diy_fp_mul(v, power));
+
+    // Round the 64-bit significand to 53 bits (fewer for subnormals)
+    int shift = 11;
+    int biased = v.e + shift + DP_EXPONENT_BIAS;
+    if (biased < 1) {
+        shift += 1 - biased;
+        biased = 0;
+        if (shift > 63) return 0.0;
+    }
+    u64 significand = (v.f >> shift) + ((v.f >> (shift - 1)) & 1);
+    if (significand == DP_HIDDEN_BIT << 1) {
+        significand >>= 1;
+        biased++;
+    } else if (biased == 0 && (significand & DP_HIDDEN_BIT)) {
+        biased = 1;
+    }
+    if (biased >= 0x7FF) return 1.0 / 0.0;
+    union { u64 bits; double d; } result = { ((u64)biased << 52) | (significand & DP_SIGNIFICAND_MASK) };
+    return result.d;
+}
+
+// Parse a JSON number that spans exactly p[0..len). Mantissas below 2^53
+// with a power of ten up to 22 convert exactly; others go through json_scale.
+static int json_number(const char* p, unsigned int len, double* out) {
+    unsigned int i = 0;
+    int negative = 0;
+    if (i < len && p[i] == '-') {
+        negative = 1;
+        i++;
+    }
+    if (i == len || !json_is_digit(p[i])) return 0;
+
+    u64 mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    if (p[i] == '0') {
+        i++;
+    } else {
+        for (; i < len && json_is_digit(p[i]); i++) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (u64)(p[i] - '0');
+                if (mantissa) digits++;
+            } else {
+                exponent++;
+            }
+        }
+    }
+    if (i < len && p[i] == '.') {
+        i++;
+        if (i == len || !json_is_digit(p[i])) return 0;
+        for (; i < len && json_is_digit(p[i]); i++) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (u64)(p[i] - '0');
+                if (mantissa) digits++;
+                exponent--;
+            }
+        }
+    }
+    if (i < len && (p[i] == 'e' || p[i] == 'E')) {
+        i++;
+        int exp_sign = 1;
+        if (i < len && (p[i] == '-' || p[i] == '+')) exp_sign = p[i++] == '-' ? -1 : 1;
+        if (i == len || !json_is_digit(p[i])) return 0;
+        int e = 0;
+        for (; i < len && json_is_digit(p[i]); i++) {
+            if (e < 10000) e = e * 10 + (p[i] - '0');
+        }
+        exponent += exp_sign * e;
+    }
+    if (i != len) return 0;
+
+    double value;
+    if (mantissa == 0) {
+        value = 0.0;
+    } else if (mantissa < (1ull << 53) && exponent >= -22 && exponent <= 22) {
+        value = exponent < 0 ? (double)mantissa / json_pow10[-exponent] : (double)mantissa * json_pow10[exponent];
+    } else {
+        value = json_scale(mantissa, exponent);
+    }
+    *out = negative ? -value : value;
+    return 1;
+}
+
+// Length of the number/literal starting at p (the padding ends it)
+static unsigned int json_atom_len(const char* p) {
+    unsigned int n = 0;
+    for (;; n++) {
+        char c = p[n];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '"' || c == ',' || c == ':' ||
+            c == '{' || c == '}' || c == '[' || c == ']') return n;
+    }
+}
+
+static int json_hex4(const char* p, unsigned int* out) {
+    unsigned int v = 0;
+    for (int i = 0; i < 4; i++) {
+        int h = hex_value(p[i]);
+        if (h < 0) return 0;
+        v = v << 4 | (unsigned int)h;
+    }
+    *out = v;
+    return 1;
+}
+
+// Decodes the escape whose letter is s[r] (the byte after a backslash) into a
+// code point. Returns the bytes it spans from s[r], or 0 if it is malformed.
+static unsigned int json_escape(const char* s, unsigned int r, unsigned int len, unsigned int* cp) {
+    switch (s[r]) {
+        case '"': case '\\': case '/': *cp = (unsigned char)s[r]; return 1;
+        case 'b': *cp = '\b'; return 1;
+        case 'f': *cp = '\f'; return 1;
+        case 'n': *cp = '\n'; return 1;
+        case 'r': *cp = '\r'; return 1;
+        case 't': *cp = '\t'; return 1;
+        case 'u': {
+            if (r + 5 > len || !json_hex4(s + r + 1, cp)) return 0;
+            if (*cp >= 0xDC00 && *cp < 0xE000) return 0;
+            if (*cp < 0xD800 || *cp >= 0xDC00) return 5;
+            unsigned int low;
+            if (r + 11 > len || s[r + 5] != '\\' || s[r + 6] != 'u' || !json_hex4(s + r + 7, &low)) return 0;
+            if (low < 0xDC00 || low >= 0xE000) return 0;
+            *cp = 0x10000 + ((*cp - 0xD800) << 10) + (low - 0xDC00);
+            return 11;
+        }
+        default: return 0;
+    }
+}
+
+// Every backslash in s[0..len) starts a well-formed escape
+static int json_escapes_valid(const char* s, unsigned int len) {
+    unsigned int r = mem_find_byte(s, len, '\\');
+    while (r < len) {
+        unsigned int cp, n = r + 1 < len ? json_escape(s, r + 1, len, &cp) : 0;
+        if (!n) return 0;
+        r += 1 + n;
+        r += mem_find_byte(s + r, len - r, '\\');
+    }
+    return 1;
+}
+
+typedef struct {
+    const char* buf;
+    const unsigned int* index;
+    unsigned int count;
+    unsigned int next;  // next entry of index
+    u64* tape;
+    unsigned int len;   // tape words written
+} json_builder;
+
+// A string at index[next - 1]: its closing quote is the next entry
+static int json_build_string(json_builder* b, unsigned int open) {
+    if (b->next >= b->count) return 0;
+    unsigned int close = b->index[b->next++];
+    if (b->buf[close] != '"') return 0;
+    if (!json_escapes_valid(b->buf + open + 1, close - open - 1)) return 0;
+    b->tape[b->len++] = json_word('"', open + 1);
+    b->tape[b->len++] = close - open - 1;
+    return 1;
+}
+
+// An object key and the ':' after it
+static int json_build_key(json_builder* b) {
+    if (b->next >= b->count) return 0;
+    unsigned int at = b->index[b->next++];
+    if (b->buf[at] != '"' || !json_build_string(b, at)) return 0;
+    return b->next < b->count && b->buf[b->index[b->next++]] == ':';
+}
+
+static int json_build_atom(json_builder* b, unsigned int at) {
+    const char* p = b->buf + at;
+    unsigned int len = json_atom_len(p);
+    if (len == 4 && mem_equal(p, "true", 4)) {
+        b->tape[b->len++] = json_word('t', 0);
+    } else if (len == 5 && mem_equal(p, "false", 5)) {
+        b->tape[b->len++] = json_word('f', 0);
+    } else if (len == 4 && mem_equal(p, "null", 4)) {
+        b->tape[b->len++] = json_word('n', 0);
+    } else {
+        union { double d; u64 bits; } number;
+        if (!json_number(p, len, &number.d)) return 0;
+        b->tape[b->len++] = json_word('d', 0);
+        b->tape[b->len++] = number.bits;
+    }
+    return 1;
+}
+
+static int json_build_tape(json_builder* b) {
+    unsigned int open[JSON_MAX_DEPTH];
+    unsigned int counts[JSON_MAX_DEPTH];
+    int depth = 0;
+    for (;;) {
+        // Expecting a value
+        if (b->next >= b->count) return 0;
+        if (depth > 0 && counts[depth - 1] < JSON_MAX_COUNT) counts[depth - 1]++;
+        unsigned int at = b->index[b->next++];
+        char c = b->buf[at];
+        if (c == '{' || c == '[') {
+            if (depth == JSON_MAX_DEPTH) return 0;
+            open[depth] = b->len;
+            counts[depth] = 0;
+            depth++;
+            b->tape[b->len++] = json_word(c, 0);
+            char close = c == '{' ? '}' : ']';
+            if (b->next >= b->count || b->buf[b->index[b->next]] != close) {
+                if (c == '{' && !json_build_key(b)) return 0;
+                continue;
+            }
+        } else if (c == '"') {
+            if (!json_build_string(b, at)) return 0;
+        } else if (c == '}' || c == ']' || c == ':' || c == ',') {
+            return 0;
+        } else if (!json_build_atom(b, at)) {
+            return 0;
+        }
+
+        // After a value: close containers until a ',' asks for the next one
+        for (;;) {
+            if (depth == 0) return b->next == b->count;
+            if (b->next >= b->count) return 0;
+            char next = b->buf[b->index[b->next++]];
+            unsigned int top = open[depth - 1];
+            char kind = (char)(b->tape[top] >> 56);
+            if (next == ',') {
+                if (kind == '{' && !json_build_key(b)) return 0;
+                break;
+            }
+            if (next != (kind == '{' ? '}' : ']')) return 0;
+            b->tape[b->len++] = json_word(next, top);
+            b->tape[top] |= (u64)(b->len) | ((u64)counts[depth - 1] << 32);
+            depth--;
+        }
+    }
+}
+
+char* nerd_json_parse_n(const char* json, unsigned int len) {
+    if (!json) return 0;
+    // Round up and keep one spare block so every SIMD load and atom scan
+    // stays inside the copy
+    unsigned int padded = (len + JSON_BLOCK) & ~(unsigned int)(JSON_BLOCK - 1);
+    nerd_json* j = (nerd_json*)wasm_alloc(sizeof(nerd_json));
+    j->buf = wasm_alloc(padded + JSON_BLOCK);
+    memcpy(j->buf, json, len);
+    memset(j->buf + len, ' ', padded + JSON_BLOCK - len);
+    j->root = 0;
+    j->is_view = 0;
+    j->tape = 0;
+    j->tree = 0;
+
+    unsigned int* index = (unsigned int*)wasm_alloc(((unsigned long)padded + 1) * sizeof(unsigned int));
+    int count = json_index(j->buf, padded, index);
+    if (count > 0) {
+        json_builder b = {j->buf, index, (unsigned int)count, 0, 0, 0};
+        // Strings and numbers take two words per index entry, everything else one
+        b.tape = (u64*)wasm_alloc((unsigned long)count * 2 * sizeof(u64));
+        if (json_build_tape(&b)) j->tape = b.tape;
+        else wasm_free((char*)b.tape);
+    }
+    wasm_free((char*)index);
+    if (!j->tape) {
+        wasm_free(j->buf);
+        wasm_free((char*)j);
+        return 0;
+    }
+    return (char*)j;
+}
+
+char* nerd_json_parse(const char* json) {
+    return nerd_json_parse_n(json, (unsigned int)my_strlen(json));
+}
+
+// ----------------------------------------------------------------------------
+// Lookups
+// ----------------------------------------------------------------------------
+
+// Tape index after the value at `at`
+static unsigned int json_skip(const nerd_json* j, unsigned int at) {
+    switch (json_type(j, at)) {
+        case '{': case '[': return json_payload(j, at);
+        case '"': case 'd': return at + 2;
+        default: return at + 1;
+    }
+}
+
+static unsigned int json_put_utf8(char* p, unsigned int cp) {
+    if (cp < 0x80) {
+        p[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        p[0] = (char)(0xC0 | cp >> 6);
+        p[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        p[0] = (char)(0xE0 | cp >> 12);
+        p[1] = (char)(0x80 | (cp >> 6 & 0x3F));
+        p[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    p[0] = (char)(0xF0 | cp >> 18);
+    p[1] = (char)(0x80 | (cp >> 12 & 0x3F));
+    p[2] = (char)(0x80 | (cp >> 6 & 0x3F));
+    p[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Unescape s[0..len) in place (the output is never longer). Returns the
+// decoded length, or -1 for a malformed escape (the parser has already
+// rejected those).
+static int json_unescape(char* s, unsigned int len) {
+    unsigned int r = mem_find_byte(s, len, '\\');
+    unsigned int w = r;
+    while (r < len) {
+        char c = s[r++];
+        if (c != '\\') {
+            s[w++] = c;
+            continue;
+        }
+        unsigned int cp, n = r < len ? json_escape(s, r, len, &cp) : 0;
+        if (!n) return -1;
+        r += n;
+        w += json_put_utf8(s + w, cp);
+    }
+    return (int)w;
+}
+
+// The string at `at`, unescaped and NUL-terminated on first use
+static int json_string(const nerd_json* j, unsigned int at, nerd_slice* out) {
+    if (json_type(j, at) != '"') return 0;
+    char* s = j->buf + json_payload(j, at);
+    u64 len = j->tape[at + 1];
+    if (!(len & JSON_STRING_DECODED)) {
+        int decoded = json_unescape(s, (unsigned int)len);
+        if (decoded < 0) return 0;
+        s[decoded] = '\0';
+        len = (u64)decoded | JSON_STRING_DECODED;
+        j->tape[at + 1] = len;
+    }
+    *out = slice_make(s, (unsigned int)len);
+    return 1;
+}
+
+enum json_path_step {
+    JSON_PATH_END,
+    JSON_PATH_KEY,    // .name (or a leading name)
+    JSON_PATH_INDEX,  // [n]
+    JSON_PATH_ERROR,
+};
+
+// Next step of a path such as "a.b[2]" starting at path[*i]
+static int json_path_next(const char* path, unsigned int len, unsigned int* i, nerd_slice* key, unsigned int* index) {
+    while (*i < len && path[*i] == '.') (*i)++;
+    if (*i == len) return JSON_PATH_END;
+    if (path[*i] == '[') {
+        unsigned int n = 0;
+        unsigned int start = ++(*i);
+        for (; *i < len && json_is_digit(path[*i]); (*i)++) n = n * 10 + (unsigned int)(path[*i] - '0');
+        if (*i == start || *i == len || path[*i] != ']') return JSON_PATH_ERROR;
+        (*i)++;
+        *index = n;
+        return JSON_PATH_INDEX;
+    }
+    unsigned int start = *i;
+    while (*i < len && path[*i] != '.' && path[*i] != '[') (*i)++;
+    *key = slice_make(path + start, *i - start);
+    return JSON_PATH_KEY;
+}
+
+// Tape index of the value at `path` ("a.b[2]", "[0].id", "" for the root),
+// or -1
+static int json_find(const nerd_json* j, const char* path, unsigned int path_len) {
+    if (!j || !j->tape) return -1;
+    unsigned int at = j->root;
+    unsigned int i = 0;
+    nerd_slice key;
+    unsigned int n;
+    for (;;) {
+        int step = json_path_next(path, path_len, &i, &key, &n);
+        if (step == JSON_PATH_END) return (int)at;
+        if (step == JSON_PATH_INDEX) {
+            if (json_type(j, at) != '[') return -1;
+            unsigned int k = at + 1;
+            for (; n > 0 && json_type(j, k) != ']'; n--) k = json_skip(j, k);
+            if (json_type(j, k) == ']') return -1;
+            at = k;
+        } else if (step == JSON_PATH_KEY) {
+            if (json_type(j, at) != '{') return -1;
+            unsigned int k = at + 1;
+            for (;;) {
+                if (json_type(j, k) == '}') return -1;
+                nerd_slice name;
+                if (json_string(j, k, &name) && slice_eq(name, key)) break;
+                k = json_skip(j, k + 2);
+            }
+            at = k + 2;
+        } else {
+            return -1;
+        }
+    }
+}
+
+static int json_find_cstr(const char* j, const char* path) {
+    return json_find((const nerd_json*)j, path, path ? (unsigned int)my_strlen(path) : 0);
+}
+
+char* nerd_json_get_string_n(const char* j, const char* p, unsigned int p_len) {
+    int at = json_find((const nerd_json*)j, p, p_len);
+    nerd_slice s;
+    if (at < 0 || !json_string((const nerd_json*)j, (unsigned int)at, &s)) return 0;
+    return (char*)s.ptr;
+}
+
+char* nerd_json_get_string(const char* j, const char* p) {
+    return nerd_json_get_string_n(j, p, p ? (unsigned int)my_strlen(p) : 0);
+}
+
+double nerd_json_get_number(const char* j, const char* p) {
+    const nerd_json* doc = (const nerd_json*)j;
+    int at = json_find_cstr(j, p);
+    if (at < 0 || json_type(doc, (unsigned int)at) != 'd') return 0;
+    union { u64 bits; double d; } number = {doc->tape[at + 1]};
+    return number.d;
+}
+
+int nerd_json_get_bool(const char* j, const char* p) {
+    int at = json_find_cstr(j, p);
+    return at >= 0 && json_type((const nerd_json*)j, (unsigned int)at) == 't';
+}
+
+// A handle on the object or array at `p` that shares the document's buffers
+char* nerd_json_get_object(const char* j, const char* p) {
+    const nerd_json* doc = (const nerd_json*)j;
+    int at = json_find_cstr(j, p);
+    if (at < 0) return 0;
+    char type = json_type(doc, (unsigned int)at);
+    if (type != '{' && type != '[') return 0;
+    nerd_json* view = (nerd_json*)wasm_alloc(sizeof(nerd_json));
+    *view = *doc;
+    view->root = (unsigned int)at;
+    view->is_view = 1;
+    return (char*)view;
+}
+
+// Members of an object or elements of an array
+int nerd_json_count(const char* j, const char* p) {
+    const nerd_json* doc = (const nerd_json*)j;
+    int at = json_find_cstr(j, p);
+    if (at < 0) return 0;
+    char type = json_type(doc, (unsigned int)at);
+    if (type != '{' && type != '[') return 0;
+    return (int)(doc->tape[at] >> 32 & JSON_MAX_COUNT);
+}
+
+int nerd_json_has(const char* j, const char* p) {
+    return json_find_cstr(j, p) >= 0;
+}
+
+void nerd_json_free(char* ptr) {
+    nerd_json* j = (nerd_json*)ptr;
+    if (!j) return;
+    if (!j->is_view) {
+        wasm_free((char*)j->tape);
+        wasm_free(j->buf);
+    }
+    wasm_free((char*)j);
+}
+
+// Getter and nerd_json_stringify strings live on the request heap until it is
+// reset
+void nerd_json_free_string(char* ptr) { (void)ptr; }
+
+// ----------------------------------------------------------------------------
+// Writer
+// ----------------------------------------------------------------------------
+//
+// Streams compact JSON into any byte sink (the output region or a string
+// builder): separators, escaping and number formatting happen as values are
+// written, with no intermediate tree. Pretty mode matches
+// JSON.stringify(value, null, 2).
+
+typedef struct json_writer {
+    void (*emit)(void*, nerd_slice);
+    void* sink;
+    int pretty;
+    int depth;
+    int after_key;                        // the next value completes a member
+    unsigned char empty[JSON_MAX_DEPTH];  // nothing written yet at this depth
+} json_writer;
+
+static void json_writer_init(json_writer* w, void (*emit)(void*, nerd_slice), void* sink, int pretty) {
+    w->emit = emit;
+    w->sink = sink;
+    w->pretty = pretty;
+    w->depth = 0;
+    w->after_key = 0;
+}
+
+static void json_emit(json_writer* w, const char* p, unsigned int len) {
+    w->emit(w->sink, slice_make(p, len));
+}
+
+static void json_newline(json_writer* w) {
+    static const char spaces[] = "\n                                ";
+    if (!w->pretty) return;
+    unsigned int indent = (unsigned int)w->depth * 2;
+    unsigned int chunk = indent < sizeof(spaces) - 2 ? indent : sizeof(spaces) - 2;
+    json_emit(w, spaces, chunk + 1);
+    for (indent -= chunk; indent; indent -= chunk) {
+        chunk = indent < sizeof(spaces) - 2 ? indent : sizeof(spaces) - 2;
+        json_emit(w, spaces + 1, chunk);
+    }
+}
+
+// Separator and indentation before a value or key
+static void json_value_start(json_writer* w) {
+    if (w->after_key) {
+        w->after_key = 0;
+        return;
+    }
+    if (w->depth == 0) return;
+    if (!w->empty[w->depth - 1]) json_emit(w, ",", 1);
+    w->empty[w->depth - 1] = 0;
+    json_newline(w);
+}
+
+static void json_write_begin(json_writer* w, char open) {
+    json_value_start(w);
+    json_emit(w, &open, 1);
+    w->empty[w->depth++] = 1;
+}
+
+static void json_write_end(json_writer* w, char close) {
+    w->depth--;
+    if (!w->empty[w->depth]) json_newline(w);
+    json_emit(w, &close, 1);
+}
+
+static void json_write_quoted(json_writer* w, nerd_slice s) {
+    json_emit(w, "\"", 1);
+    escape_to(s, ESCAPE_JSON, w->emit, w->sink);
+    json_emit(w, "\"", 1);
+}
+
+static void json_write_key(json_writer* w, nerd_slice key) {
+    json_value_start(w);
+    json_write_quoted(w, key);
+    if (w->pretty) json_emit(w, ": ", 2);
+    else json_emit(w, ":", 1);
+    w->after_key = 1;
+}
+
+static void json_write_string(json_writer* w, nerd_slice s) {
+    json_value_start(w);
+    json_write_quoted(w, s);
+}
+
+// Raw token: true, false, null
+static void json_write_literal(json_writer* w, const char* token) {
+    json_value_start(w);
+    json_emit(w, token, (unsigned int)my_strlen(token));
+}
+
+// Shortest round-trip form, as JSON.stringify; NaN and infinities are null
+static void json_write_number(json_writer* w, double value) {
+    if (value != value || value - value != 0.0) {
+        json_write_literal(w, "null");
+        return;
+    }
+    char buf[NUM_BUFFER_SIZE];
+    int len = format_double(buf, value, NUM_FORMAT_SHORTEST, 0, 0);
+    json_value_start(w);
+    json_emit(w, buf, (unsigned int)len);
+}
+
+// Re-serializes a parsed value (minified unless the writer is pretty)
+static void json_write_tape(json_writer* w, const nerd_json* j, unsigned int at) {
+    nerd_slice s;
+    switch (json_type(j, at)) {
+        case '{': case '[': {
+            char open = json_type(j, at);
+            unsigned int end = json_payload(j, at) - 1;
+            json_write_begin(w, open);
+            for (unsigned int k = at + 1; k < end; k = json_skip(j, k)) {
+                if (open == '{') {
+                    json_write_key(w, json_string(j, k, &s) ? s : slice_make(0, 0));
+                    k += 2;
+                }
+                json_write_tape(w, j, k);
+            }
+            json_write_end(w, open == '{' ? '}' : ']');
+            break;
+        }
+        case '"':
+            json_write_string(w, json_string(j, at, &s) ? s : slice_make(0, 0));
+            break;
+        case 'd': {
+            union { u64 bits; double d; } number = {j->tape[at + 1]};
+            json_write_number(w, number.d);
+            break;
+        }
+        case 't': json_write_literal(w, "true"); break;
+        case 'f': json_write_literal(w, "false"); break;
+        default: json_write_literal(w, "null"); break;
+    }
+}
+
+// ?pretty=1 asks for indented API output
+static int json_pretty_requested(void) {
+    return slice_eq_cstr(query_get("pretty"), "1");
+}
+
+// ----------------------------------------------------------------------------
+// Host values (JSON event list written by the host)
+// ----------------------------------------------------------------------------
+//
+// Layout, all integers little-endian u32:
+//   count,
+//   count * (kind, a, b)   -- keys/strings: (offset, len) into the pool;
+//                             numbers: the f64's low and high words
+//   pool                   -- UTF-8 bytes, no terminators
+// The host walks its value once; render_json writes it with the writer, so
+// escaping and number formatting happen in Wasm.
+
+// Kind order is shared with JSON_EVENT in worker.js
+enum json_event {
+    JSON_EVENT_OBJECT,
+    JSON_EVENT_ARRAY,
+    JSON_EVENT_END,
+    JSON_EVENT_KEY,
+    JSON_EVENT_STRING,
+    JSON_EVENT_NUMBER,
+    JSON_EVENT_TRUE,
+    JSON_EVENT_FALSE,
+    JSON_EVENT_NULL,
+};
+
+static char* json_input_block = 0;
+static unsigned int json_input_cap = 0;
+static unsigned int json_input_count = 0;
+
+__attribute__((export_name("wasm_reserve_json")))
+char* wasm_reserve_json(unsigned int bytes) {
+    if (json_input_block) wasm_free(json_input_block);
+    json_input_block = wasm_alloc(bytes);
+    json_input_cap = bytes;
+    json_input_count = 0;
+    return json_input_block;
+}
+
+// Validates the event list: pool bounds, balanced containers no deeper than
+// JSON_MAX_DEPTH, keys exactly where objects expect them and a single root
+// value. Returns the event count, or -1 (and leaves the list empty).
+__attribute__((export_name("wasm_commit_json")))
+int wasm_commit_json(void) {
+    json_input_count = 0;
+    if (!json_input_block || json_input_cap < 4) return -1;
+    const unsigned int* header = (const unsigned int*)json_input_block;
+    unsigned long count = header[0];
+    // Bounded before multiplying: on wasm32 count * 12 can wrap
+    if (count == 0 || count > (json_input_cap - 4) / 12) return -1;
+    unsigned long index_bytes = 4 + count * 12;
+    unsigned long pool_size = json_input_cap - index_bytes;
+
+    unsigned char in_object[JSON_MAX_DEPTH];
+    int depth = 0;
+    int expect_key = 0;
+    int roots = 0;
+    for (unsigned long i = 0; i < count; i++) {
+        const unsigned int* event = header + 1 + i * 3;
+        unsigned int kind = event[0];
+        if (kind == JSON_EVENT_KEY || kind == JSON_EVENT_STRING) {
+            unsigned long off = event[1], len = event[2];
+            if (off > pool_size || len > pool_size - off) return -1;
+        }
+        if (kind == JSON_EVENT_END) {
+            if (depth == 0 || (in_object[depth - 1] && !expect_key)) return -1;
+            depth--;
+            expect_key = depth > 0 && in_object[depth - 1];
+            continue;
+        }
+        if ((kind == JSON_EVENT_KEY) != expect_key) return -1;
+        if (kind == JSON_EVENT_KEY) {
+            expect_key = 0;
+            continue;
+        }
+        if (kind > JSON_EVENT_NULL) return -1;
+        if (depth == 0 && roots++) return -1;
+        if (kind == JSON_EVENT_OBJECT || kind == JSON_EVENT_ARRAY) {
+            if (depth == JSON_MAX_DEPTH) return -1;
+            in_object[depth++] = kind == JSON_EVENT_OBJECT;
+            expect_key = kind == JSON_EVENT_OBJECT;
+        } else {
+            expect_key = depth > 0 && in_object[depth - 1];
+        }
+    }
+    if (depth != 0) return -1;
+    json_input_count = (unsigned int)count;
+    return (int)count;
+}
+
+// Writes the committed host value to the output (compact unless ?pretty=1)
+__attribute__((export_name("render_json")))
+double render_json(void) {
+    const unsigned int* events = (const unsigned int*)json_input_block + 1;
+    const char* pool = json_input_block + 4 + json_input_count * 12;
+    unsigned char is_array[JSON_MAX_DEPTH];
+    json_writer w;
+    json_writer_init(&w, out_emit, 0, json_pretty_requested());
+    for (unsigned int i = 0; i < json_input_count; i++, events += 3) {
+        switch (events[0]) {
+            case JSON_EVENT_OBJECT:
+            case JSON_EVENT_ARRAY:
+                is_array[w.depth] = events[0] == JSON_EVENT_ARRAY;
+                json_write_begin(&w, is_array[w.depth] ? '[' : '{');
+                break;
+            case JSON_EVENT_END:
+                json_write_end(&w, is_array[w.depth - 1] ? ']' : '}');
+                break;
+            case JSON_EVENT_KEY:
+                json_write_key(&w, slice_make(pool + events[1], events[2]));
+                break;
+            case JSON_EVENT_STRING:
+                json_write_string(&w, slice_make(pool + events[1], events[2]));
+                break;
+            case JSON_EVENT_NUMBER: {
+                union { unsigned int words[2]; double d; } number = {{events[1], events[2]}};
+                json_write_number(&w, number.d);
+                break;
+            }
+            case JSON_EVENT_TRUE: json_write_literal(&w, "true"); break;
+            case JSON_EVENT_FALSE: json_write_literal(&w, "false"); break;
+            default: json_write_literal(&w, "null"); break;
+        }
+    }
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Building
+// ----------------------------------------------------------------------------
+//
+// nerd_json_new documents are small trees on the request heap: nerd_json_set_*
+// creates the objects and arrays along the path (a.b[2]) and replaces
+// whatever was there. nerd_json_stringify writes them (or a parsed
+// document) with the writer. Built documents are write-only and parsed
+// ones read-only.
+
+struct json_node {
+    char type;         // '{' '[' '"' 'd' 't' 'f' 'n', as on the tape
+    nerd_slice key;    // member name when the parent is an object
+    nerd_slice string;
+    double number;
+    json_node* first;
+    json_node* last;
+    json_node* next;
+};
+
+static nerd_slice json_copy(const char* p, unsigned int len) {
+    char* copy = wasm_alloc(len + 1);
+    memcpy(copy, p, len);
+    copy[len] = '\0';
+    return slice_make(copy, len);
+}
+
+static json_node* json_node_new(char type, json_node* parent) {
+    json_node* node = (json_node*)wasm_alloc(sizeof(json_node));
+    memset(node, 0, sizeof(json_node));
+    node->type = type;
+    if (parent) {
+        if (parent->last) parent->last->next = node;
+        else parent->first = node;
+        parent->last = node;
+    }
+    return node;
+}
+
+// Turns `node` into an empty value of `type` (children are dropped)
+static void json_node_reset(json_node* node, char type) {
+    node->type = type;
+    node->first = node->last = 0;
+}
+
+// The node at `path`, created along the way; 0 for a malformed path
+static json_node* json_tree_at(nerd_json* j, const char* path) {
+    if (!j || !j->tree) return 0;
+    json_node* node = j->tree;
+    unsigned int len = path ? (unsigned int)my_strlen(path) : 0;
+    unsigned int i = 0;
+    nerd_slice key;
+    unsigned int n;
+    for (int depth = 1;; depth++) {
+        int step = json_path_next(path, len, &i, &key, &n);
+        if (step == JSON_PATH_END) return node;
+        if (step == JSON_PATH_ERROR || depth == JSON_MAX_DEPTH) return 0;
+        if (step == JSON_PATH_KEY) {
+            if (node->type != '{') json_node_reset(node, '{');
+            json_node* child = node->first;
+            while (child && !slice_eq(child->key, key)) child = child->next;
+            if (!child) {
+                child = json_node_new('n', node);
+                child->key = json_copy(key.ptr, key.len);
+            }
+            node = child;
+        } else {
+            if (node->type != '[') json_node_reset(node, '[');
+            json_node* child = node->first ? node->first : json_node_new('n', node);
+            for (; n > 0; n--) child = child->next ? child->next : json_node_new('n', node);
+            node = child;
+        }
+    }
+}
+
+static void json_write_tree(json_writer* w, const json_node* node) {
+    switch (node->type) {
+        case '{': case '[':
+            json_write_begin(w, node->type);
+            for (const json_node* child = node->first; child; child = child->next) {
+                if (node->type == '{') json_write_key(w, child->key);
+                json_write_tree(w, child);
+            }
+            json_write_end(w, node->type == '{' ? '}' : ']');
+            break;
+        case '"': json_write_string(w, node->string); break;
+        case 'd': json_write_number(w, node->number); break;
+        case 't': json_write_literal(w, "true"); break;
+        case 'f': json_write_literal(w, "false"); break;
+        default: json_write_literal(w, "null"); break;
+    }
+}
+
+char* nerd_json_new(void) {
+    nerd_json* j = (nerd_json*)wasm_alloc(sizeof(nerd_json));
+    memset(j, 0, sizeof(nerd_json));
+    j->tree = json_node_new('{', 0);
+    return (char*)j;
+}
+
+void nerd_json_set_string(char* j, const char* p, const char* v) {
+    json_node* node = json_tree_at((nerd_json*)j, p);
+    if (!node) return;
+    json_node_reset(node, v ? '"' : 'n');
+    if (v) node->string = json_copy(v, (unsigned int)my_strlen(v));
+}
+
+void nerd_json_set_number(char* j, const char* p, double v) {
+    json_node* node = json_tree_at((nerd_json*)j, p);
+    if (!node) return;
+    json_node_reset(node, 'd');
+    node->number = v;
+}
+
+void nerd_json_set_bool(char* j, const char* p, int v) {
+    json_node* node = json_tree_at((nerd_json*)j, p);
+    if (node) json_node_reset(node, v ? 't' : 'f');
+}
+
+// Compact JSON text for a built or parsed document, NUL-terminated
+char* nerd_json_stringify(const char* json) {
+    const nerd_json* j = (const nerd_json*)json;
+    if (!j || (!j->tree && !j->tape)) return 0;
+    nerd_sb* sb = nerd_sb_new(256);
+    json_writer w;
+    json_writer_init(&w, sb_emit, sb, 0);
+    if (j->tree) json_write_tree(&w, j->tree);
+    else json_write_tape(&w, j, j->root);
+    nerd_sb_append(sb, "", 1);
+    return sb->data;
+}
+
+// ============================================================================
+// Isolate State
+// ============================================================================
+//
+// Lookup tables that never change between requests. wasm_init builds them
+// on the heap below heap_start, where wasm_reset_heap leaves them alone, and
+// a snapshotted module starts with them already in memory.
+
+static void isolate_tables_init(void) {
+    blog_rating_weights = nerd_map_new(3);
+    nerd_map_set_number(blog_rating_weights, "🟢", sizeof("🟢") - 1, 3.0);
+    nerd_map_set_number(blog_rating_weights, "🟡", sizeof("🟡") - 1, 2.0);
+    nerd_map_set_number(blog_rating_weights, "🔴", sizeof("🔴") - 1, 1.0);
+}
+
+// ============================================================================
+// Request State
+// ============================================================================
+
+// Drop everything cached for the previous request (called by wasm_reset_heap)
+static void request_state_reset(void) {
+    output_len = 0;
+    output_newlines = 0;
+    output_flush_threshold = 0;
+    shared_buffer = 0;  // Its block went away with the heap
+    shared_buffer_cap = 0;
+    shared_buffer_len = 0;
+    request_path.ptr = 0;
+    request_method.ptr = 0;
+    request_origin.ptr = 0;
+    records_block = 0;
+    records_cap = 0;
+    records_count = 0;
+    records_loaded = 0;
+    records_cursor = -1;
+    records_atoms = 0;
+    intern_map = 0;
+    intern_strings = 0;
+    intern_count = 0;
+    intern_cap = 0;
+    intern_ranks = 0;
+    slots_block = 0;
+    slots_cap = 0;
+    slots_count = 0;
+    route_current = -1;
+    route_param_value = slice_make(0, 0);
+    query_count = 0;
+    query_parsed = 0;
+    json_input_block = 0;
+    json_input_cap = 0;
+    json_input_count = 0;
+}
@@ -0,0 +1,83 @@
+/**
+ * async_host.js - Suspending host calls for the NERD runtime
+ *
+ * js_http_fetch, js_kv_get and js_load_posts return promises; the render that
+ * called them is suspended until they settle, then resumes with the staged
+ * result's byte length (or -1) and copies it out with js_take_result. JS
+ * Promise Integration does this in the engine. A module built with
+ * ASYNCIFY=1 (wasm-opt --asyncify, see tools/asyncify.sh) exports asyncify_*,
+ * and callExport unwinds and rewinds the Wasm stack itself instead. With
+ * neither, async imports answer -1 at once.
+ *
+ * `host` is the per-instance state: { mode, instance, result, pending,
+ * resumeValue, asyncData, entries }.
+ */
+
+// asyncify_get_state() while the stack is being rebuilt
+const ASYNCIFY_REWINDING = 2;
+
+// "jspi", "asyncify" or null for `module`
+export function asyncMode(module) {
+  if (WebAssembly.Module.exports(module).some(e => e.name === "asyncify_start_unwind")) return "asyncify";
+  if (typeof WebAssembly.Suspending === "function" && typeof WebAssembly.promising === "function") return "jspi";
+  return null;
+}
+
+export function asyncHost(mode) {
+  return { mode, instance: null, result: null, pending: null, resumeValue: 0, asyncData: 0, entries: new Map() };
+}
+
+// Wraps `fn` (resolving to bytes or null) as a suspending import for `host`
+export function asyncImport(host, fn) {
+  const staged = async (...args) => {
+    const bytes = await fn(...args);
+    host.result = bytes;
+    return bytes ? bytes.length : -1;
+  };
+  if (host.mode === "jspi") return new WebAssembly.Suspending(staged);
+  if (host.mode !== "asyncify") return () => -1;
+  return (...args) => {
+    const { exports } = host.instance;
+    if (exports.asyncify_get_state() === ASYNCIFY_REWINDING) {
+      exports.asyncify_stop_rewind();
+      return host.resumeValue;
+    }
+    host.pending = staged(...args);
+    host.asyncData = exports.wasm_async_stack();
+    exports.asyncify_start_unwind(host.asyncData);
+    return 0;
+  };
+}
+
+// js_take_result: copies the staged bytes into the block Wasm reserved
+export function takeResult(host, ptr, len) {
+  new Uint8Array(host.instance.exports.memory.buffer, ptr, len).set(host.result.subarray(0, len));
+  host.result = null;
+}
+
+// Calls an export that may suspend; resolves to its return value
+export async function callExport(host, name) {
+  const { exports } = host.instance;
+  if (host.mode === "jspi") {
+    let entry = host.entries.get(name);
+    if (!entry) {
+      entry = WebAssembly.promising(exports[name]);
+      host.entries.set(name, entry);
+    }
+    return entry();
+  }
+  let result = exports[name]();
+  if (host.mode !== "asyncify") return result;
+  // Each unwind lands here; the export is re-entered to rewind to the import
+  while (host.pending) {
+    exports.asyncify_stop_unwind();
+    try {
+      host.resumeValue = await host.pending;
+    } finally {
+      host.pending = null;
+    }
+    exports.asyncify_start_rewind(host.asyncData);
+    result = exports[name]();
+  }
+  return result;
+}
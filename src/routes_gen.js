@@ -0,0 +1,26 @@
+// routes_gen.js - generated by tools/gen_routes.mjs from routes.json. Do not edit.
+
+export const ROUTE = Object.freeze({
+  NONE: 0,
+  API_POSTS: 1,
+  API_POST: 2,
+  API_POST_SAVE: 3,
+  API_POST_DELETE: 4,
+  HOME: 5,
+  ABOUT: 6,
+  BLOG: 7,
+  POST: 8,
+  TG_WEBHOOK: 9,
+  ADMIN_SAVE: 10,
+  ADMIN_GENERATE: 11,
+  ADMIN: 12,
+  RSS: 13,
+  FEED: 14,
+  MCP: 15,
+  RAG: 16,
+  SUBSCRIBE: 17,
+  SUBSCRIBERS: 18,
+  METRICS: 19,
+  PLUGINS: 20,
+  RAW: 21,
+});
@@ -7,10 +7,8 @@
  */
 
 import wasmModule from "../cms.wasm";
-
-// let outputBuffer = []; // Moved to local scope
-let currentPath = "/";
-let currentMethod = "GET";
+import { ROUTE } from "./routes_gen.js";
+import { asyncMode, asyncHost, asyncImport, callExport, takeResult } from "./async_host.js";
 
 const MOE_SYSTEM_PROMPT = `You are Moe, a world-class financial analyst and writer who emulates the narrative style of Morgan Housel. Your tone is analytical, neutral, and precise. You focus on the timeless principles of economics and business psychology. Avoid jargon and marketing filler. Write with clarity, focusing on unit economics, capital allocation, and competitive moats. Your goal is to provide a concise yet rich narrative that lets an investor understand how a business works. 
 
@@ -25,20 +23,445 @@ You must assign a rating based on the following:
 
 You must also identify the company's current Market Capitalization in USD Billions.`;
 
+// ============================================================================
+// Host Bindings (Wasm <-> JS string bridge)
+// ============================================================================
+
+// One codec pair per isolate; TextDecoder/TextEncoder are stateless here.
+const textDecoder = new TextDecoder();
+const textEncoder = new TextEncoder();
+
+// Byte views over each instance's memory, rebuilt only when memory.grow has
+// replaced (and detached) the underlying ArrayBuffer.
+const memoryViews = new WeakMap();
+
+function memoryBytes(memory) {
+  let view = memoryViews.get(memory);
+  if (!view || view.buffer !== memory.buffer) {
+    view = new Uint8Array(memory.buffer);
+    memoryViews.set(memory, view);
+  }
+  return view;
+}
+
+// Copies `len` bytes out of Wasm memory: the only copy on the output path.
+function copyBytes(memory, ptr, len) {
+  return memoryBytes(memory).slice(ptr, ptr + len);
+}
+
 function readCString(memory, ptr) {
-  const bytes = new Uint8Array(memory.buffer);
-  let end = ptr;
-  while (bytes[end] !== 0 && end < bytes.length) end++;
-  return new TextDecoder().decode(bytes.subarray(ptr, end));
+  const bytes = memoryBytes(memory);
+  let end = bytes.indexOf(0, ptr);
+  if (end < 0) end = bytes.length;
+  return textDecoder.decode(bytes.subarray(ptr, end));
 }
 
+// Encodes straight into Wasm memory and NUL-terminates. Returns the full
+// encoded length (like snprintf); a result >= maxLen means the string was
+// truncated to fit.
 function writeCString(memory, ptr, str, maxLen) {
-  const bytes = new Uint8Array(memory.buffer);
-  const encoded = new TextEncoder().encode(str);
-  const len = Math.min(encoded.length, maxLen - 1);
-  for (let i = 0; i < len; i++) bytes[ptr + i] = encoded[i];
-  bytes[ptr + len] = 0;
-  return len;
+  const bytes = memoryBytes(memory);
+  const { read, written } = textEncoder.encodeInto(str, bytes.subarray(ptr, ptr + maxLen - 1));
+  bytes[ptr + written] = 0;
+  if (read === str.length) return written;
+  return written + textEncoder.encode(str.slice(read)).length;
+}
+
+function readString(memory, ptr, len) {
+  return textDecoder.decode(memoryBytes(memory).subarray(ptr, ptr + len));
+}
+
+// Async host calls (see async_host.js): JSPI, an asyncify build, or neither
+const ASYNC_MODE = asyncMode(wasmModule);
+
+// Calls a render export that may suspend; resolves to its return value
+function callRuntime(runtime, name) {
+  return callExport(runtime.host, name);
+}
+
+// "Name: value" lines (see nerd_http_*) -> fetch headers
+function parseHeaderLines(text) {
+  const headers = new Headers();
+  for (const line of text.split("\n")) {
+    const colon = line.indexOf(":");
+    if (colon > 0) headers.append(line.slice(0, colon).trim(), line.slice(colon + 1).trim());
+  }
+  return headers;
+}
+
+// Instantiates the runtime with imports that read the request through
+// `host.io` ({ path, method, origin, query, env, write, loadPosts }): the
+// context of the request that has the instance checked out (see
+// acquireRuntime).
+async function instantiateRuntime() {
+  const host = { ...asyncHost(ASYNC_MODE), io: null };
+  const memory = () => instance.exports.memory;
+  const instance = await WebAssembly.instantiate(wasmModule, {
+    env: {
+      js_write: (ptr, len) => { host.io.write(copyBytes(instance.exports.memory, ptr, len)); },
+      js_get_request_path: (ptr, maxLen) => writeCString(instance.exports.memory, ptr, host.io.path, maxLen),
+      js_get_request_method: (ptr, maxLen) => writeCString(instance.exports.memory, ptr, host.io.method, maxLen),
+      js_get_request_origin: (ptr, maxLen) => writeCString(instance.exports.memory, ptr, host.io.origin, maxLen),
+      js_get_request_query: (ptr, maxLen) => writeCString(instance.exports.memory, ptr, host.io.query, maxLen),
+      puts: (ptr) => { host.io.write(textEncoder.encode(readCString(instance.exports.memory, ptr))); return 0; },
+      printf: () => 0,
+
+      // Arguments are read before the first await; the network and KV
+      // failures a template can handle come back as -1 (a null string)
+      js_http_fetch: asyncImport(host, (mPtr, mLen, uPtr, uLen, hPtr, hLen, bPtr, bLen) => {
+        const init = {
+          method: readString(memory(), mPtr, mLen),
+          headers: parseHeaderLines(readString(memory(), hPtr, hLen)),
+          body: bLen ? copyBytes(memory(), bPtr, bLen) : undefined,
+        };
+        return fetch(readString(memory(), uPtr, uLen), init)
+          .then(res => res.arrayBuffer())
+          .then(buf => new Uint8Array(buf), () => null);
+      }),
+      js_kv_get: asyncImport(host, (ptr, len) => {
+        return host.io.env.CONTENT.get(readString(memory(), ptr, len), { type: "arrayBuffer" })
+          .then(buf => buf && new Uint8Array(buf), () => null);
+      }),
+      // Errors here fail the render, like a failed KV read before it
+      js_load_posts: asyncImport(host, async () => {
+        return host.io.loadPosts ? recordsBuffer(await host.io.loadPosts()) : null;
+      }),
+      js_take_result: (ptr, len) => takeResult(host, ptr, len),
+    },
+  });
+  host.instance = instance;
+  runtimeMetrics.instantiations++;
+  return host;
+}
+
+// ============================================================================
+// Instance Pool
+// ============================================================================
+//
+// A rendering request checks an instance out for its whole lifetime, streamed
+// body included, so the imports read exactly one request context; routes with
+// no Wasm work (HOST_ONLY_ROUTES) return it right after matching. Idle instances
+// stay warm: the pool grows with in-flight requests and, as they finish,
+// keeps at most in-flight + POOL_IDLE_SLACK of them (POOL_MAX_IDLE overall).
+// wasm_reset_heap clears the heap, output region and request caches between
+// requests.
+
+const POOL_IDLE_SLACK = 2;
+const POOL_MAX_IDLE = 8;
+const idleRuntimes = [];
+let runtimesInFlight = 0;
+
+// The request's handle: { instance, io, host, holds }. Every holder (the
+// request, a streaming body) calls releaseRuntime once.
+async function acquireRuntime(io) {
+  runtimesInFlight++;
+  runtimeMetrics.in_flight_peak = Math.max(runtimeMetrics.in_flight_peak, runtimesInFlight);
+  let host = idleRuntimes.pop();
+  if (!host) {
+    try {
+      host = await instantiateRuntime();
+    } catch (error) {
+      runtimesInFlight--;
+      throw error;
+    }
+  }
+  host.io = io;
+  return { instance: host.instance, io, host, holds: 1 };
+}
+
+function releaseRuntime(runtime) {
+  if (--runtime.holds > 0) return;
+  runtimesInFlight--;
+  const { host } = runtime;
+  host.io = null;
+  if (!host.broken) idleRuntimes.push(host);
+  // Instances dropped here are garbage collected with their memory
+  const keep = Math.min(POOL_MAX_IDLE, runtimesInFlight + POOL_IDLE_SLACK);
+  if (idleRuntimes.length > keep) idleRuntimes.length = keep;
+}
+
+// A trap can leave the instance mid-call (shadow stack pointer, half-written
+// state), so it is dropped instead of going back to the pool
+function discardRuntime(runtime) {
+  runtime.host.broken = true;
+}
+
+// Route id (see routes.json) and `:param` for the request, matched in Wasm
+// after clearing whatever the previous request left in the instance
+function matchRoute(runtime) {
+  const { instance } = runtime;
+  if (instance.exports.wasm_reset_heap) instance.exports.wasm_reset_heap();
+  const id = instance.exports.wasm_route();
+  const ptr = instance.exports.wasm_route_param();
+  const slug = textDecoder.decode(memoryBytes(instance.exports.memory).subarray(ptr, ptr + instance.exports.wasm_route_param_len()));
+  return { id, slug };
+}
+
+// Sizes the runtime's input region for `str` (UTF-8 needs at most 3 bytes per
+// UTF-16 unit), encodes into it in place and passes the exact byte length.
+function writeSharedBuffer(instance, str) {
+  const ptr = instance.exports.wasm_reserve_shared_buffer(str.length * 3);
+  const { written } = textEncoder.encodeInto(str, memoryBytes(instance.exports.memory).subarray(ptr, ptr + str.length * 3));
+  instance.exports.wasm_set_shared_buffer_len(written);
+}
+
+// Named input slots: u32 count, count * (name_off, name_len, value_off,
+// value_len), then a UTF-8 pool, encoded straight into a block the runtime
+// reserves. Templates look values up by name.
+function writeSlots(instance, slots) {
+  const entries = Object.entries(slots).filter(([, value]) => value !== undefined && value !== null);
+  const indexBytes = 4 + entries.length * 16;
+  let capacity = indexBytes;
+  for (const [name, value] of entries) capacity += (name.length + String(value).length) * 3;
+
+  const ptr = instance.exports.wasm_reserve_slots(capacity);
+  const bytes = memoryBytes(instance.exports.memory);
+  const index = new DataView(bytes.buffer, ptr, indexBytes);
+  const pool = bytes.subarray(ptr + indexBytes, ptr + capacity);
+  index.setUint32(0, entries.length, true);
+  let offset = 0;
+  entries.forEach(([name, value], i) => {
+    for (const [k, str] of [[0, name], [8, String(value)]]) {
+      const { written } = textEncoder.encodeInto(str, pool.subarray(offset));
+      index.setUint32(4 + i * 16 + k, offset, true);
+      index.setUint32(8 + i * 16 + k, written, true);
+      offset += written;
+    }
+  });
+  instance.exports.wasm_commit_slots();
+}
+
+// Field order mirrors enum record_field in runtime_wasm.c
+const RECORD_FIELDS = [
+  "slug", "title", "date", "rating", "market_cap", "company_name", "stock_price",
+  "pe_ratio", "market_cap_formatted", "category", "tags", "excerpt", "pub_date", "content_html",
+  "author",
+];
+
+// Low-cardinality fields: each distinct value is encoded into the pool once
+// and shared by every record (the runtime interns them to integer ids).
+const SHARED_FIELDS = new Set(["rating", "category", "tags", "author"]);
+const SHARED_FIELD_MASK = RECORD_FIELDS.map(f => SHARED_FIELDS.has(f));
+
+function recordValue(post, field) {
+  const value = post[field];
+  if (value === undefined || value === null || value === false) return "";
+  return Array.isArray(value) ? value.join(",") : String(value);
+}
+
+// Posts as the runtime's packed record table (see "Post Records" in
+// runtime_wasm.c): a u32 header and (offset, len) index, then one UTF-8 pool.
+// `size` is an upper bound; encodeRecords returns the bytes actually used.
+function recordTable(posts) {
+  const rows = posts.map(p => RECORD_FIELDS.map(f => recordValue(p, f)));
+  const indexBytes = 8 + rows.length * RECORD_FIELDS.length * 8;
+  const counted = new Set();
+  let poolBound = 0;
+  for (const row of rows) {
+    row.forEach((value, field) => {
+      if (SHARED_FIELD_MASK[field]) {
+        if (counted.has(value)) return;
+        counted.add(value);
+      }
+      poolBound += value.length * 3;
+    });
+  }
+  return { rows, indexBytes, poolBound, size: indexBytes + poolBound };
+}
+
+// `bytes` must be 4-byte aligned and at least table.size long
+function encodeRecords(table, bytes) {
+  const { rows, indexBytes, poolBound } = table;
+  const index = new Uint32Array(bytes.buffer, bytes.byteOffset, indexBytes / 4);
+  index[0] = rows.length;
+  index[1] = RECORD_FIELDS.length;
+  const pool = bytes.subarray(indexBytes, indexBytes + poolBound);
+  const shared = new Map();
+  let slot = 2, used = 0;
+  for (const row of rows) {
+    row.forEach((value, field) => {
+      const seen = SHARED_FIELD_MASK[field] && shared.get(value);
+      if (seen) {
+        index[slot++] = seen[0];
+        index[slot++] = seen[1];
+        return;
+      }
+      const { written } = textEncoder.encodeInto(value, pool.subarray(used));
+      if (SHARED_FIELD_MASK[field]) shared.set(value, [used, written]);
+      index[slot++] = used;
+      index[slot++] = written;
+      used += written;
+    });
+  }
+  return indexBytes + used;
+}
+
+// Encodes the table in place in a block the runtime reserves. Returns the
+// record count the runtime accepted.
+function writeRecords(instance, posts) {
+  const table = recordTable(posts);
+  const ptr = instance.exports.wasm_reserve_records(table.size);
+  encodeRecords(table, memoryBytes(instance.exports.memory).subarray(ptr, ptr + table.size));
+  return instance.exports.wasm_commit_records();
+}
+
+// The same table staged for js_load_posts, trimmed to its exact size
+function recordsBuffer(posts) {
+  const table = recordTable(posts);
+  const bytes = new Uint8Array(table.size);
+  return bytes.subarray(0, encodeRecords(table, bytes));
+}
+
+// Event kinds, in the order of enum json_event in runtime_wasm.c
+const JSON_EVENT = { OBJECT: 0, ARRAY: 1, END: 2, KEY: 3, STRING: 4, NUMBER: 5, TRUE: 6, FALSE: 7, NULL: 8 };
+
+// Flattens `value` into the runtime's JSON event list with JSON.stringify's
+// rules (toJSON, undefined members skipped, undefined array items -> null).
+function jsonEvents(value, events) {
+  if (value && typeof value.toJSON === "function") value = value.toJSON();
+  switch (typeof value) {
+    case "string": events.push(JSON_EVENT.STRING, value); return;
+    case "number":
+      if (Number.isFinite(value)) events.push(JSON_EVENT.NUMBER, value);
+      else events.push(JSON_EVENT.NULL, null);
+      return;
+    case "boolean": events.push(value ? JSON_EVENT.TRUE : JSON_EVENT.FALSE, null); return;
+    case "object":
+      if (value === null) break;
+      if (Array.isArray(value)) {
+        events.push(JSON_EVENT.ARRAY, null);
+        for (const item of value) jsonEvents(item, events);
+      } else {
+        events.push(JSON_EVENT.OBJECT, null);
+        for (const [key, item] of Object.entries(value)) {
+          if (item === undefined || typeof item === "function" || typeof item === "symbol") continue;
+          events.push(JSON_EVENT.KEY, key);
+          jsonEvents(item, events);
+        }
+      }
+      events.push(JSON_EVENT.END, null);
+      return;
+  }
+  events.push(JSON_EVENT.NULL, null);
+}
+
+// Writes `value` as the runtime's JSON event list (see "Host values" in
+// runtime_wasm.c): u32 count, count * (kind, a, b), then a UTF-8 pool. Keys
+// repeat across posts, so each distinct key goes into the pool once; numbers
+// travel as raw f64 bits. render_json then escapes, formats and writes it.
+function writeJson(instance, value) {
+  const events = [];
+  jsonEvents(value, events);
+  const count = events.length / 2;
+  const indexBytes = 4 + count * 12;
+  const keys = new Set();
+  let poolBound = 0;
+  for (let i = 0; i < events.length; i += 2) {
+    if (events[i] === JSON_EVENT.KEY) {
+      if (keys.has(events[i + 1])) continue;
+      keys.add(events[i + 1]);
+    }
+    if (typeof events[i + 1] === "string") poolBound += events[i + 1].length * 3;
+  }
+
+  const ptr = instance.exports.wasm_reserve_json(indexBytes + poolBound);
+  const bytes = memoryBytes(instance.exports.memory);
+  const index = new DataView(bytes.buffer, ptr, indexBytes);
+  const pool = ptr + indexBytes;
+  const shared = new Map();
+  let used = 0;
+  index.setUint32(0, count, true);
+  for (let i = 0, at = 4; i < events.length; i += 2, at += 12) {
+    const kind = events[i], item = events[i + 1];
+    index.setUint32(at, kind, true);
+    if (kind === JSON_EVENT.NUMBER) {
+      index.setFloat64(at + 4, item, true);
+    } else if (typeof item === "string") {
+      let entry = kind === JSON_EVENT.KEY && shared.get(item);
+      if (!entry) {
+        const { written } = textEncoder.encodeInto(item, bytes.subarray(pool + used, pool + poolBound));
+        entry = [used, written];
+        used += written;
+        if (kind === JSON_EVENT.KEY) shared.set(item, entry);
+      }
+      index.setUint32(at + 4, entry[0], true);
+      index.setUint32(at + 8, entry[1], true);
+    } else {
+      index.setUint32(at + 4, 0, true);
+      index.setUint32(at + 8, 0, true);
+    }
+  }
+  return instance.exports.wasm_commit_json();
+}
+
+// Render input that writes itself: `render_json` output for any JSON value
+function jsonInput(value) {
+  return (instance) => writeJson(instance, value);
+}
+
+// ============================================================================
+// Runtime Telemetry (mirrors struct wasm_stats in runtime_wasm.c)
+// ============================================================================
+
+const STATS_FIELDS = [
+  "heap_high_water", "memory_bytes", "alloc_count", "free_count",
+  "request_bytes", "failed_allocs", "shared_buffer_high_water", "shared_buffer_truncations",
+];
+
+const STATS_HEADERS = {
+  heap_high_water: "X-Nerd-Heap-Peak",
+  memory_bytes: "X-Nerd-Memory",
+  alloc_count: "X-Nerd-Allocs",
+  request_bytes: "X-Nerd-Alloc-Bytes",
+  failed_allocs: "X-Nerd-Alloc-Failures",
+  shared_buffer_high_water: "X-Nerd-Buffer-Peak",
+  shared_buffer_truncations: "X-Nerd-Buffer-Truncations",
+};
+
+// Isolate-wide aggregates, served by GET /api/metrics
+const runtimeMetrics = {
+  instantiations: 0,
+  in_flight_peak: 0,
+  renders: 0,
+  heap_high_water: 0,
+  memory_bytes: 0,
+  alloc_count: 0,
+  request_bytes: 0,
+  failed_allocs: 0,
+  shared_buffer_high_water: 0,
+  shared_buffer_truncations: 0,
+};
+
+function readRuntimeStats(instance) {
+  if (!instance.exports.wasm_get_stats) return null;
+  const ptr = instance.exports.wasm_get_stats();
+  const words = new Uint32Array(instance.exports.memory.buffer, ptr, STATS_FIELDS.length);
+  const stats = {};
+  STATS_FIELDS.forEach((name, i) => { stats[name] = words[i]; });
+  return stats;
+}
+
+// Folds one render's counters into runtimeMetrics and returns them as headers
+function recordRuntimeStats(instance) {
+  const stats = readRuntimeStats(instance);
+  if (!stats) return {};
+  runtimeMetrics.renders++;
+  runtimeMetrics.heap_high_water = Math.max(runtimeMetrics.heap_high_water, stats.heap_high_water);
+  runtimeMetrics.memory_bytes = Math.max(runtimeMetrics.memory_bytes, stats.memory_bytes);
+  runtimeMetrics.shared_buffer_high_water = Math.max(runtimeMetrics.shared_buffer_high_water, stats.shared_buffer_high_water);
+  runtimeMetrics.alloc_count += stats.alloc_count;
+  runtimeMetrics.request_bytes += stats.request_bytes;
+  runtimeMetrics.failed_allocs += stats.failed_allocs;
+  runtimeMetrics.shared_buffer_truncations += stats.shared_buffer_truncations;
+  const headers = {};
+  for (const [name, header] of Object.entries(STATS_HEADERS)) headers[header] = String(stats[name]);
+  return headers;
+}
+
+// The runtime buffers output in linear memory; this hands the remainder to
+// js_write as one (ptr, len) view at the end of a render.
+function flushWasmOutput(instance) {
+  if (instance.exports.wasm_output_flush) instance.exports.wasm_output_flush();
 }
 
 // Simple markdown to HTML converter
@@ -83,43 +506,91 @@ function parseFrontmatter(content) {
   return { meta, body: match[2] };
 }
 
-export default {
+// Routes whose handlers never call into the runtime after matching
+const HOST_ONLY_ROUTES = new Set([
+  ROUTE.API_POST_SAVE,
+  ROUTE.API_POST_DELETE,
+  ROUTE.TG_WEBHOOK,
+  ROUTE.ADMIN_SAVE,
+  ROUTE.ADMIN_GENERATE,
+  ROUTE.MCP,
+  ROUTE.RAG,
+  ROUTE.SUBSCRIBE,
+  ROUTE.SUBSCRIBERS,
+  ROUTE.METRICS,
+]);
+
+const worker = {
   async fetch(request, env, ctx) {
     const url = new URL(request.url);
-    currentPath = url.pathname || "/";
-    currentMethod = request.method;
-    let outputBuffer = [];
+    // Request state lives in this context object, never in module globals
+    const runtime = await acquireRuntime({
+      path: url.pathname || "/",
+      method: request.method,
+      origin: url.origin,
+      query: url.search.slice(1),
+      env,
+      write: null,
+      // Set by routes whose templates pull their post list (js_load_posts)
+      loadPosts: null,
+    });
+    let route;
+    try {
+      // One Wasm walk over the path picks the route and extracts its :param
+      route = matchRoute(runtime);
+    } catch (error) {
+      releaseRuntime(runtime);
+      throw error;
+    }
+    // Handlers without Wasm work hand the instance back before their KV,
+    // AI and webhook awaits instead of pinning it for the whole request
+    if (HOST_ONLY_ROUTES.has(route.id)) {
+      releaseRuntime(runtime);
+      return worker.route(request, env, ctx, url, null, route);
+    }
+    try {
+      return await worker.route(request, env, ctx, url, runtime, route);
+    } finally {
+      releaseRuntime(runtime);
+    }
+  },
+
+  // `runtime` is null for HOST_ONLY_ROUTES
+  async route(request, env, ctx, url, runtime, route) {
+    const outputBuffer = [];
+    if (runtime) runtime.io.write = (chunk) => outputBuffer.push(chunk);
+    const instance = runtime && runtime.instance;
 
     // ========================================================================
     // Content API (data-first, immutable)
     // ========================================================================
     
-    // GET /api/posts - List all posts
-    if (currentPath === "/api/posts" && currentMethod === "GET") {
-      const list = await env.CONTENT.list({ prefix: "post:" });
-      const posts = (await Promise.all(
-        list.keys.map(async (k) => {
-          if (k.metadata) return { slug: k.name.replace("post:", ""), ...k.metadata };
-          const content = await env.CONTENT.get(k.name);
-          const { meta } = parseFrontmatter(content || "");
-          return {
-            slug: k.name.replace("post:", ""),
-            title: meta.title || k.name,
-            date: meta.date || null,
-            excerpt: meta.excerpt || null,
-            published: true
-          };
-        })
-      )).filter(p => p.published !== false);
-      posts.sort((a, b) => (b.date || "").localeCompare(a.date || ""));
-      return new Response(JSON.stringify(posts, null, 2), {
-        headers: { "Content-Type": "application/json", "X-Powered-By": "NERD-CMS" },
-      });
+    // GET /api/posts - List all posts (compact JSON written by Wasm; ?pretty=1 indents)
+    if (route.id === ROUTE.API_POSTS) {
+      return streamWasmRender(async () => {
+        const list = await env.CONTENT.list({ prefix: "post:" });
+        const posts = (await Promise.all(
+          list.keys.map(async (k) => {
+            if (k.metadata) return { slug: k.name.replace("post:", ""), ...k.metadata };
+            const content = await env.CONTENT.get(k.name);
+            const { meta } = parseFrontmatter(content || "");
+            return {
+              slug: k.name.replace("post:", ""),
+              title: meta.title || k.name,
+              date: meta.date || null,
+              excerpt: meta.excerpt || null,
+              published: true
+            };
+          })
+        )).filter(p => p.published !== false);
+        posts.sort((a, b) => (b.date || "").localeCompare(a.date || ""));
+        return jsonInput(posts);
+      }, "render_json", runtime, env, "application/json");
     }
 
     // GET /api/posts/:slug - Get single post
-    if (currentPath.startsWith("/api/posts/") && currentMethod === "GET") {
-      const slug = currentPath.replace("/api/posts/", "");
+    if (route.id === ROUTE.API_POST) {
+      const slug = route.slug;
       const content = await env.CONTENT.get(`post:${slug}`);
       if (!content) {
         return new Response(JSON.stringify({ error: "Not found" }), {
@@ -128,14 +599,12 @@ export default {
         });
       }
       const { meta, body } = parseFrontmatter(content);
-      return new Response(JSON.stringify({ slug, ...meta, body, html: markdownToHtml(body) }, null, 2), {
-        headers: { "Content-Type": "application/json", "X-Powered-By": "NERD-CMS" },
-      });
+      return callWasmRender(jsonInput({ slug, ...meta, body, html: markdownToHtml(body) }), "render_json", runtime, env, null, "application/json");
     }
 
     // POST /api/posts/:slug - Create/update post (append-only log in future)
-    if (currentPath.startsWith("/api/posts/") && currentMethod === "POST") {
-      const slug = currentPath.replace("/api/posts/", "");
+    if (route.id === ROUTE.API_POST_SAVE) {
+      const slug = route.slug;
       const body = await request.text();
       await env.CONTENT.put(`post:${slug}`, body);
       return new Response(JSON.stringify({ success: true, slug }), {
@@ -144,8 +613,8 @@ export default {
     }
 
     // DELETE /api/posts/:slug - Delete post
-    if (currentPath.startsWith("/api/posts/") && currentMethod === "DELETE") {
-      const slug = currentPath.replace("/api/posts/", "");
+    if (route.id === ROUTE.API_POST_DELETE) {
+      const slug = route.slug;
       await env.CONTENT.delete(`post:${slug}`);
       return new Response(JSON.stringify({ success: true, deleted: slug }), {
         headers: { "Content-Type": "application/json", "X-Powered-By": "NERD-CMS" },
@@ -153,24 +622,21 @@ export default {
     }
 
     // GET / (Home)
-    if (currentPath === "/" || currentPath === "") {
-      const list = await env.CONTENT.list({ prefix: "post:", limit: 10 });
-      const posts = (await Promise.all(list.keys.map(async k => {
-        if (k.metadata) return { slug: k.name.replace("post:", ""), ...k.metadata };
-        const c = await env.CONTENT.get(k.name);
-        const { meta } = parseFrontmatter(c || "");
-        return { slug: k.name.replace("post:", ""), ...meta, published: true };
-      }))).filter(p => p.published !== false);
-
-      // SORT: Most recent first (date descending)
-      posts.sort((a, b) => (b.date || "").localeCompare(a.date || ""));
-
-      return callWasmRender(posts, "render_home", url, env);
-    }
+    if (route.id === ROUTE.HOME) {
+      // Pulled by print_post_list once the overview has been streamed
+      runtime.io.loadPosts = async () => {
+        const list = await env.CONTENT.list({ prefix: "post:", limit: 10 });
+        const posts = (await Promise.all(list.keys.map(async k => {
+          if (k.metadata) return { slug: k.name.replace("post:", ""), ...k.metadata };
+          const c = await env.CONTENT.get(k.name);
+          const { meta } = parseFrontmatter(c || "");
+          return { slug: k.name.replace("post:", ""), ...meta, published: true };
+        }))).filter(p => p.published !== false);
 
-    // GET /about
-    if (currentPath === "/about") {
-      return callWasmRender(null, "render_about", url, env);
+        // SORT: Most recent first (date descending)
+        return posts.sort((a, b) => (b.date || "").localeCompare(a.date || ""));
+      };
+      return streamWasmRender(null, "render_home", runtime, env);
     }
 
     // ========================================================================
@@ -178,70 +644,42 @@ export default {
     // ========================================================================
 
     // GET /blog - List posts with server-side search and sort
-    if (currentPath === "/blog") {
-      const list = await env.CONTENT.list({ prefix: "post:" });
-      let posts = (await Promise.all(
-        list.keys.map(async (k) => {
-          if (k.metadata) return { slug: k.name.replace("post:", ""), ...k.metadata };
-          const content = await env.CONTENT.get(k.name);
-          const { meta } = parseFrontmatter(content || "");
-          return { slug: k.name.replace("post:", ""), ...meta, published: true };
-        })
-      )).filter(p => p.published !== false);
-      
-      // SERVER-SIDE FILTERING (No-JS)
-      const q = url.searchParams.get("q")?.toLowerCase();
-      if (q) {
-        posts = posts.filter(p => {
-          const text = ((p.title || p.slug) + " " + (p.category || "") + " " + (Array.isArray(p.tags) ? p.tags.join(" ") : (p.tags || ""))).toLowerCase();
-          return text.includes(q);
-        });
-      }
-
-      // SERVER-SIDE SORTING (No-JS)
-      const sortBy = url.searchParams.get("sort") || "date";
-      if (sortBy === "market-cap") {
-        posts.sort((a, b) => (parseFloat(b.market_cap) || 0) - (parseFloat(a.market_cap) || 0));
-      } else if (sortBy === "rating") {
-        const ratingWeight = { "🟢": 3, "🟡": 2, "🔴": 1 };
-        posts.sort((a, b) => (ratingWeight[b.rating] || 0) - (ratingWeight[a.rating] || 0));
-      } else if (sortBy === "category") {
-        posts.sort((a, b) => (a.category || "").localeCompare(b.category || ""));
-      } else if (sortBy === "tag") {
-        const firstTag = p => Array.isArray(p.tags) ? p.tags[0] : (p.tags || "").split(",")[0];
-        posts.sort((a, b) => (firstTag(a) || "").localeCompare(firstTag(b) || ""));
-      } else {
-        // Default: Date Descending
-        posts.sort((a, b) => (b.date || "").localeCompare(a.date || ""));
-      }
-
-      return callWasmRender(posts, "render_blog", url, env);
+    if (route.id === ROUTE.BLOG) {
+      // Headers and the page head go out immediately; print_blog_list pulls
+      // the posts (KV reads) when the render reaches it.
+      runtime.io.loadPosts = async () => {
+        const list = await env.CONTENT.list({ prefix: "post:" });
+        // Search (?q=) and sort (?sort=) run in Wasm (print_blog_list)
+        return (await Promise.all(
+          list.keys.map(async (k) => {
+            if (k.metadata) return { slug: k.name.replace("post:", ""), ...k.metadata };
+            const content = await env.CONTENT.get(k.name);
+            const { meta } = parseFrontmatter(content || "");
+            return { slug: k.name.replace("post:", ""), ...meta, published: true };
+          })
+        )).filter(p => p.published !== false);
+      };
+      return streamWasmRender(null, "render_blog", runtime, env);
     }
 
     // GET /blog/:slug - Single post
-    if (currentPath.startsWith("/blog/")) {
-      const slug = currentPath.replace("/blog/", "");
+    if (route.id === ROUTE.POST) {
+      const slug = route.slug;
       const content = await env.CONTENT.get(`post:${slug}`);
       if (!content) {
-        return callWasmRender(null, "render_404", url, env);
+        return callWasmRender(null, "render_404", runtime, env);
       }
       const { meta, body } = parseFrontmatter(content);
-      const rating = meta.rating ? `<span class="post-rating" style="font-size: 1.5rem; margin-left: 10px;">${meta.rating}</span>` : "";
-      
-      let html = `<header class="post-header">
-        <h1>${meta.title || slug.toUpperCase()}</h1>
-        <div class="post-meta">
-          ${meta.author || "Anonymous"} · ${meta.date || ""} ${rating}
-        </div>
-      </header>
-      <div class="post-content">
-        ${markdownToHtml(body)}
-      </div>`;
-      
-      const postData = { slug, ...meta, html };
-      
-      // Pass data to Wasm and render
-      return callWasmRender(postData, "render_post", url, env);
+
+      // Header fields and article HTML go over as slots; Wasm lays out the page
+      return callWasmRender(null, "render_post", runtime, env, {
+        slug,
+        title: meta.title,
+        author: meta.author,
+        date: meta.date,
+        rating: meta.rating,
+        body_html: markdownToHtml(body),
+      });
     }
 
     // ========================================================================
@@ -259,7 +697,7 @@ export default {
     }
 
     // TELEGRAM WEBHOOK HANDLER
-    if (currentPath.startsWith("/api/tg-webhook/") && currentMethod === "POST") {
+    if (route.id === ROUTE.TG_WEBHOOK) {
       try {
         const body = await request.json();
         const text = body.message?.text || body.channel_post?.text;
@@ -308,7 +746,7 @@ export default {
     }
 
     // POST /api/admin/save - Save post
-    if (currentPath === "/api/admin/save" && currentMethod === "POST") {
+    if (route.id === ROUTE.ADMIN_SAVE) {
       if (!verifyAuth(request)) {
         return new Response(JSON.stringify({ error: "Unauthorized" }), { status: 401 });
       }
@@ -327,7 +765,7 @@ export default {
     }
 
     // POST /api/admin/generate - AI Analysis (Moe)
-    if (currentPath === "/api/admin/generate" && currentMethod === "POST") {
+    if (route.id === ROUTE.ADMIN_GENERATE) {
       if (!verifyAuth(request)) return new Response(JSON.stringify({ error: "Unauthorized" }), { status: 401 });
       try {
         const { symbol } = await request.json();
@@ -347,53 +785,41 @@ export default {
       }
     }
 
-    // GET /admin - Admin Interface
-    if (currentPath === "/admin") {
-       return callWasmRender(null, "render_admin", url, env);
-    }
-
     // ========================================================================
     // Discovery (Phase 4)
     // ========================================================================
 
     // GET /rss.xml
-    if (currentPath === "/rss.xml") {
-       const list = await env.CONTENT.list({ prefix: "post:" });
-       const posts = (await Promise.all(list.keys.map(async k => {
-          const c = await env.CONTENT.get(k.name);
-          const { meta, body } = parseFrontmatter(c || "");
-          return { slug: k.name.replace("post:", ""), body, ...meta };
-       }))).filter(p => p.published !== false);
-       // Format as XML items (AI-Friendly with full content)
-       const items = posts.map(p => {
-         const html = markdownToHtml(p.body || "");
-         return `<item>` +
-           `<title>${p.title}</title>` +
-           `<link>${url.origin}/blog/${p.slug}</link>` +
-           `<guid>${url.origin}/blog/${p.slug}</guid>` +
-           `<description>${p.excerpt||''}</description>` +
-           `<content:encoded><![CDATA[${html}]]></content:encoded>` +
-           `<pubDate>${new Date(p.date || Date.now()).toUTCString()}</pubDate>` +
-           `</item>`;
-       }).join("");
-       
-       const res = await callWasmRender(items, "render_rss", url, env);
-       return new Response(await res.text(), { 
-         headers: { "Content-Type": "application/xml", "X-Powered-By": "NERD-CMS" } 
-       });
+    if (route.id === ROUTE.RSS) {
+       // The channel header streams first; print_rss_items pulls the items
+       runtime.io.loadPosts = async () => {
+         const list = await env.CONTENT.list({ prefix: "post:" });
+         const posts = (await Promise.all(list.keys.map(async k => {
+            const c = await env.CONTENT.get(k.name);
+            const { meta, body } = parseFrontmatter(c || "");
+            return { slug: k.name.replace("post:", ""), body, ...meta };
+         }))).filter(p => p.published !== false);
+         // Items are rendered in Wasm (AI-Friendly with full content)
+         return posts.map(p => ({
+           ...p,
+           content_html: markdownToHtml(p.body || ""),
+           pub_date: new Date(p.date || Date.now()).toUTCString(),
+         }));
+       };
+       return streamWasmRender(null, "render_rss", runtime, env, "application/xml");
     }
 
     // GET /feed.json
-    if (currentPath === "/feed.json") {
-       const list = await env.CONTENT.list({ prefix: "post:" });
-       const posts = (await Promise.all(list.keys.map(async k => {
-          const c = await env.CONTENT.get(k.name);
-          const { meta } = parseFrontmatter(c || "");
-          return { id: k.name, url: `${url.origin}/blog/${k.name.replace("post:","")}`, ...meta };
-       }))).filter(p => p.published !== false);
-       return new Response(JSON.stringify({ version: "https://jsonfeed.org/version/1.1", title: "Research", items: posts }, null, 2), {
-         headers: { "Content-Type": "application/json" }
-       });
+    if (route.id === ROUTE.FEED) {
+       return streamWasmRender(async () => {
+         const list = await env.CONTENT.list({ prefix: "post:" });
+         const posts = (await Promise.all(list.keys.map(async k => {
+            const c = await env.CONTENT.get(k.name);
+            const { meta } = parseFrontmatter(c || "");
+            return { id: k.name, url: `${url.origin}/blog/${k.name.replace("post:","")}`, ...meta };
+         }))).filter(p => p.published !== false);
+         return jsonInput({ version: "https://jsonfeed.org/version/1.1", title: "Research", items: posts });
+       }, "render_json", runtime, env, "application/json");
     }
 
     // ========================================================================
@@ -401,7 +827,7 @@ export default {
     // ========================================================================
 
     // POST /mcp - Native MCP Server
-    if (currentPath === "/mcp" && currentMethod === "POST") {
+    if (route.id === ROUTE.MCP) {
       try {
         const body = await request.json();
         // Minimal implementation of tools/call
@@ -414,8 +840,8 @@ export default {
     }
 
     // GET /api/rag/:slug - RAG Text Chunks
-    if (currentPath.startsWith("/api/rag/")) {
-      const slug = currentPath.replace("/api/rag/", "");
+    if (route.id === ROUTE.RAG) {
+      const slug = route.slug;
       const content = await env.CONTENT.get(`post:${slug}`);
       if (!content) return new Response("Not found", { status: 404 });
       const { body } = parseFrontmatter(content);
@@ -429,7 +855,7 @@ export default {
     // ========================================================================
 
     // POST /api/subscribe
-    if (currentPath === "/api/subscribe" && currentMethod === "POST") {
+    if (route.id === ROUTE.SUBSCRIBE) {
       try {
         const { email } = await request.json();
         // Simple regex for email validation
@@ -442,7 +868,7 @@ export default {
     }
 
     // GET /api/subscribers (Admin Only)
-    if (currentPath === "/api/subscribers") {
+    if (route.id === ROUTE.SUBSCRIBERS) {
       if (!verifyAuth(request)) return new Response("Unauthorized", { status: 401 });
       
       const list = await env.CONTENT.list({ prefix: "sub:" });
@@ -452,6 +878,13 @@ export default {
       });
     }
 
+    // GET /api/metrics - Wasm runtime memory/buffer telemetry for this isolate
+    if (route.id === ROUTE.METRICS) {
+      return new Response(JSON.stringify(runtimeMetrics, null, 2), {
+        headers: { "Content-Type": "application/json", "X-Powered-By": "NERD-CMS" },
+      });
+    }
+
     // ========================================================================
     // Mechanics (Webhooks & AI Helpers)
     // ========================================================================
@@ -541,49 +974,31 @@ Tone: Analytical, neutral, precise (style of Morgan Housel).`;
     // NERD Wasm Pages
     // ========================================================================
 
+    // Routes with a data-free render_* (and unmatched paths, via render_404)
+    // are dispatched inside Wasm in one call; main is the fallback renderer.
     try {
-      const instance = await WebAssembly.instantiate(wasmModule, {
-        env: {
-          js_print_string: (ptr) => {
-            outputBuffer.push(readCString(instance.exports.memory, ptr));
-          },
-          js_print_number: (num) => {
-            outputBuffer.push(Number.isInteger(num) ? String(num) : num.toPrecision(6).replace(/\.?0+$/, ''));
-          },
-          js_get_request_path: (ptr, maxLen) => {
-            return writeCString(instance.exports.memory, ptr, currentPath, maxLen);
-          },
-          js_get_request_method: (ptr, maxLen) => {
-            return writeCString(instance.exports.memory, ptr, currentMethod, maxLen);
-          },
-          puts: (ptr) => { outputBuffer.push(readCString(instance.exports.memory, ptr)); return 0; },
-          printf: () => 0,
-        },
-      });
-
       if (instance.exports.wasm_reset_heap) instance.exports.wasm_reset_heap();
-      
-      if (currentPath === "/plugins") {
-        if (instance.exports.render_plugins) instance.exports.render_plugins();
-        else if (instance.exports.main) instance.exports.main();
-      } else if (currentPath === "/raw") {
-        if (instance.exports.render_raw) instance.exports.render_raw();
-        return new Response(outputBuffer.join("\n") + "\n", {
-          headers: { "Content-Type": "text/plain; charset=utf-8", "X-Powered-By": "NERD-CMS" },
-        });
-      } else {
-        if (instance.exports.render_404) instance.exports.render_404();
-        else if (instance.exports.main) instance.exports.main();
-        return new Response(outputBuffer.join(""), {
-          status: 404,
-          headers: { "Content-Type": "text/html; charset=utf-8", "X-Powered-By": "NERD-CMS" },
-        });
+      if (route.id === ROUTE.RAW && instance.exports.wasm_output_set_newlines) {
+        instance.exports.wasm_output_set_newlines(1);
+      }
+      // NERD pages may suspend on nerd_http_* / nerd_kv_get
+      if (!(await callRuntime(runtime, "wasm_route_dispatch")) && route.id !== ROUTE.RAW && instance.exports.main) {
+        await callRuntime(runtime, "main");
       }
+      flushWasmOutput(instance);
 
-      return new Response(outputBuffer.join(""), {
-        headers: { "Content-Type": "text/html; charset=utf-8", "X-Powered-By": "NERD-CMS" },
+      return new Response(responseBody(outputBuffer), {
+        status: route.id === ROUTE.NONE ? 404 : 200,
+        headers: {
+          "Content-Type": route.id === ROUTE.RAW ? "text/plain; charset=utf-8" : "text/html; charset=utf-8",
+          "X-Powered-By": "NERD-CMS",
+          ...recordRuntimeStats(instance),
+        },
       });
     } catch (error) {
+      // A trapped render (e.g. failed allocation) still reports its counters
+      recordRuntimeStats(instance);
+      discardRuntime(runtime);
       return new Response(`NERD CMS Error: ${error.message}\n${error.stack}`, {
         status: 500,
         headers: { "Content-Type": "text/plain" },
@@ -592,54 +1007,92 @@ Tone: Analytical, neutral, precise (style of Morgan Housel).`;
   },
 };
 
-// Helper to call Wasm with data
-async function callWasmRender(data, exportName, url, env) {
-  let localBuffer = [];
-  const instance = await WebAssembly.instantiate(wasmModule, {
-    env: {
-      js_print_string: (ptr) => { localBuffer.push(readCString(instance.exports.memory, ptr)); },
-      js_print_number: (num) => { localBuffer.push(String(num)); },
-      js_get_request_path: (ptr, maxLen) => writeCString(instance.exports.memory, ptr, url.pathname, maxLen),
-      js_get_request_method: (ptr, maxLen) => writeCString(instance.exports.memory, ptr, "GET", maxLen),
-      puts: (ptr) => { localBuffer.push(readCString(instance.exports.memory, ptr)); return 0; },
-      printf: () => 0,
-    },
-  });
+export default worker;
+
+// Runs one Wasm render on the request's runtime, handing every chunk the
+// runtime flushes to `write` as a Uint8Array.
+// Returns the runtime telemetry headers for the render.
+async function runWasmRender(data, exportName, runtime, write, flushThreshold = 0, slots = null) {
+  const { instance } = runtime;
+  runtime.io.write = write;
 
   if (instance.exports.wasm_reset_heap) instance.exports.wasm_reset_heap();
+  if (flushThreshold && instance.exports.wasm_output_set_flush_threshold) {
+    instance.exports.wasm_output_set_flush_threshold(flushThreshold);
+  }
   
-  if (data && instance.exports.wasm_get_shared_buffer) {
-    const bufferPtr = instance.exports.wasm_get_shared_buffer();
-    let dataStr = "";
-    
-    if (typeof data === "string") {
-      dataStr = data;
-    } else if (Array.isArray(data)) {
-      dataStr = data.map(p => {
-        let displayTitle = p.title || p.slug;
-        // If we have the specific financial fields, use them to construct an ultra-high-signal title
-        if (p.company_name && p.stock_price && p.pe_ratio) {
-           displayTitle = `${p.company_name} | ${p.stock_price} | PE: ${p.pe_ratio} | ${p.market_cap_formatted}`;
-        }
-        return `<li><a href="/blog/${p.slug}">${displayTitle}</a> <span class="text-secondary">(${p.date || ''})</span></li>`;
-      }).join("");
-    } else {
-      dataStr = `<h1>${data.title || data.slug}</h1>` +
-                `<div class="post-meta">${data.date || ''} ${data.author ? `by ${data.author}` : ''}</div>` +
-                `<div style="margin-top:1rem">${data.html}</div>`;
-    }
-    writeCString(instance.exports.memory, bufferPtr, dataStr, 65536);
+  // Without async host calls a template cannot pull its posts mid-render
+  if (data === null && runtime.io.loadPosts && !ASYNC_MODE) data = await runtime.io.loadPosts();
+
+  if (slots && instance.exports.wasm_reserve_slots) writeSlots(instance, slots);
+  if (typeof data === "function") {
+    // Inputs with their own encoding (e.g. jsonInput) write themselves
+    data(instance);
+  } else if (Array.isArray(data) && instance.exports.wasm_reserve_records) {
+    // Post lists go over as a packed record table; Wasm renders the markup
+    writeRecords(instance, data);
+  } else if (typeof data === "string" && instance.exports.wasm_reserve_shared_buffer) {
+    writeSharedBuffer(instance, data);
+  }
+
+  let statsHeaders = {};
+  try {
+    // May suspend on async host calls (js_load_posts, nerd_http_*, ...)
+    if (instance.exports[exportName]) await callRuntime(runtime, exportName);
+    else if (instance.exports.main) await callRuntime(runtime, "main");
+    flushWasmOutput(instance);
+  } catch (error) {
+    discardRuntime(runtime);
+    throw error;
+  } finally {
+    statsHeaders = recordRuntimeStats(instance);
   }
+  return statsHeaders;
+}
+
+// Byte chunks (or strings) -> Response body without joining or re-encoding in
+// JS. The usual single-flush render passes its one Uint8Array straight through.
+function responseBody(chunks) {
+  if (chunks.length === 1 && chunks[0] instanceof Uint8Array) return chunks[0];
+  return new Blob(chunks);
+}
+
+// Helper to call Wasm with data
+async function callWasmRender(data, exportName, runtime, env, slots = null, contentType = "text/html; charset=utf-8") {
+  let localBuffer = [];
+  const statsHeaders = await runWasmRender(data, exportName, runtime, (chunk) => localBuffer.push(chunk), 0, slots);
 
-  if (instance.exports[exportName]) instance.exports[exportName]();
-  else if (instance.exports.main) instance.exports.main();
+  return new Response(responseBody(localBuffer), {
+    headers: { "Content-Type": contentType, "X-Powered-By": "NERD-CMS", ...statsHeaders },
+  });
+}
 
-  const html = localBuffer.join("");
-  const finalHtml = html
-    .replace('value="CURRENT_Q"', `value="${url.searchParams.get("q") || ""}"`)
-    .replace(`class="sort-tab ${url.searchParams.get("sort") || "date"}"`, `class="sort-tab active"`);
+// Bytes the runtime buffers before handing a chunk to a streaming response
+const STREAM_FLUSH_BYTES = 16384;
+
+// Streaming variant: the Response goes out as soon as this returns. Data is
+// loaded inside the stream (`loadData`, or pulled by the template through
+// io.loadPosts), and every chunk the runtime flushes (threshold, print_buffer
+// boundary or async host call) is enqueued immediately instead of being joined.
+// Telemetry is still recorded for /api/metrics but cannot go in the headers.
+function streamWasmRender(loadData, exportName, runtime, env, contentType = "text/html; charset=utf-8", slots = null) {
+  // The body keeps the instance checked out after fetch has returned
+  runtime.holds++;
+  const body = new ReadableStream({
+    async start(controller) {
+      try {
+        const data = loadData ? await loadData() : null;
+        await runWasmRender(data, exportName, runtime, (chunk) => controller.enqueue(chunk), STREAM_FLUSH_BYTES, slots);
+        controller.close();
+      } catch (error) {
+        controller.error(error);
+      } finally {
+        releaseRuntime(runtime);
+      }
+    },
+  });
 
-  return new Response(finalHtml, {
-    headers: { "Content-Type": "text/html; charset=utf-8", "X-Powered-By": "NERD-CMS" },
+  return new Response(body, {
+    headers: { "Content-Type": contentType, "X-Powered-By": "NERD-CMS" },
   });
 }
@@ -0,0 +1,20 @@
+// async_dispatch.c - Page render for tests/async_dispatch.mjs
+//
+// Linked with runtime_wasm.c in place of cms.nerd. render_about is reached
+// through wasm_route_dispatch's route_renders table (an indirect call) and
+// suspends twice on nerd_http_get, then once on nerd_kv_get.
+
+extern int printf(const char* fmt, ...);
+extern char* nerd_http_get(const char* url);
+extern char* nerd_kv_get(const char* key);
+
+double render_about(void) {
+    printf("<head>");
+    for (int i = 0; i < 2; i++) {
+        const char* body = nerd_http_get(i ? "https://example.test/b" : "https://example.test/a");
+        printf("[%s]", body ? body : "null");
+    }
+    const char* value = nerd_kv_get("post:missing");
+    printf("[%s]</body>", value ? value : "null");
+    return 0.0;
+}
@@ -0,0 +1,67 @@
+#!/usr/bin/env node
+/**
+ * async_dispatch.mjs - A dispatched page render suspends and resumes intact
+ *
+ * Usage: node tests/async_dispatch.mjs <module.wasm>
+ * Drives wasm_route_dispatch for /about through src/async_host.js with
+ * imports that resolve on a later tick, and checks the page comes out whole
+ * and in order: the render's frames (including the indirect call through
+ * route_renders) must be rebuilt after every suspension. Uses asyncify when
+ * the module is instrumented, JSPI otherwise; exits 77 (skip) when neither
+ * is available.
+ */
+
+import { readFileSync } from "node:fs";
+import { asyncMode, asyncHost, asyncImport, callExport, takeResult } from "../src/async_host.js";
+
+const module = new WebAssembly.Module(readFileSync(process.argv[2]));
+const mode = asyncMode(module);
+if (!mode) {
+  console.log("skip: no JSPI and the module is not asyncified");
+  process.exit(77);
+}
+
+const decoder = new TextDecoder();
+const encoder = new TextEncoder();
+const host = asyncHost(mode);
+const memory = () => new Uint8Array(host.instance.exports.memory.buffer);
+const readString = (ptr, len) => decoder.decode(memory().subarray(ptr, ptr + len));
+const writeCString = (ptr, str, maxLen) => {
+  const { written } = encoder.encodeInto(str, memory().subarray(ptr, ptr + maxLen - 1));
+  memory()[ptr + written] = 0;
+  return written;
+};
+const later = (value) => new Promise(resolve => setTimeout(() => resolve(value), 1));
+
+let output = "";
+const fetches = [];
+host.instance = new WebAssembly.Instance(module, {
+  env: {
+    js_write: (ptr, len) => { output += readString(ptr, len); },
+    js_get_request_path: (ptr, maxLen) => writeCString(ptr, "/about", maxLen),
+    js_get_request_method: (ptr, maxLen) => writeCString(ptr, "GET", maxLen),
+    js_get_request_origin: (ptr, maxLen) => writeCString(ptr, "https://example.test", maxLen),
+    js_get_request_query: (ptr, maxLen) => writeCString(ptr, "", maxLen),
+    js_http_fetch: asyncImport(host, (mPtr, mLen, uPtr, uLen) => {
+      const url = readString(uPtr, uLen);
+      fetches.push(`${readString(mPtr, mLen)} ${url}`);
+      return later(encoder.encode(url.slice(-1).repeat(3)));
+    }),
+    js_kv_get: asyncImport(host, () => later(null)),
+    js_load_posts: asyncImport(host, () => later(null)),
+    js_take_result: (ptr, len) => takeResult(host, ptr, len),
+  },
+});
+
+const { exports } = host.instance;
+exports.wasm_reset_heap();
+const dispatched = await callExport(host, "wasm_route_dispatch");
+exports.wasm_output_flush();
+
+const expected = "<head>[aaa][bbb][null]</body>";
+const fetched = "GET https://example.test/a,GET https://example.test/b";
+if (dispatched !== 1 || output !== expected || fetches.join(",") !== fetched) {
+  console.error(`FAIL (${mode}): dispatched=${dispatched} output=${JSON.stringify(output)} fetches=${fetches}`);
+  process.exit(1);
+}
+console.log(`ok (${mode}): ${output}`);
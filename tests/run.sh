@@ -0,0 +1,25 @@
+#!/bin/bash
+# run.sh - Build the async dispatch test module and run it
+#
+# Usage: tests/run.sh
+# Links runtime_wasm.c with tests/async_dispatch.c (no NERD program) twice:
+# through tools/asyncify.sh for the asyncify driver, and as is for JSPI.
+
+set -e
+cd "$(dirname "$0")/.."
+
+LLVM_BIN="${LLVM_BIN:-/opt/homebrew/opt/llvm/bin}"
+WASM_FEATURES="-msimd128 -mbulk-memory"
+OUT="tests/out"
+mkdir -p "$OUT"
+
+node tools/gen_routes.mjs routes.json
+$LLVM_BIN/clang --target=wasm32-unknown-unknown -O2 $WASM_FEATURES -c runtime_wasm.c -o "$OUT/runtime_wasm.o"
+$LLVM_BIN/clang --target=wasm32-unknown-unknown -O2 $WASM_FEATURES -c tests/async_dispatch.c -o "$OUT/async_dispatch.o"
+wasm-ld --no-entry --export-all --export-memory --allow-undefined --initial-memory=524288 \
+    -o "$OUT/async_dispatch.wasm" "$OUT/async_dispatch.o" "$OUT/runtime_wasm.o"
+tools/asyncify.sh "$OUT/async_dispatch.wasm" "$OUT/async_dispatch.asyncify.wasm"
+
+node tests/async_dispatch.mjs "$OUT/async_dispatch.asyncify.wasm"
+# Skipped (77) on node versions without WebAssembly.Suspending
+node tests/async_dispatch.mjs "$OUT/async_dispatch.wasm" || [ $? -eq 77 ]
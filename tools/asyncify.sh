@@ -0,0 +1,18 @@
+#!/bin/bash
+# asyncify.sh - Asyncify fallback for runtimes without JS Promise Integration
+#
+# Usage: tools/asyncify.sh <in.wasm> [out.wasm]
+# Instruments every call path that can reach a suspending import so the host
+# (src/async_host.js) can unwind and rewind the Wasm stack. Indirect calls are
+# instrumented too: wasm_route_dispatch reaches page renders through the
+# route_renders table, and those renders may suspend on nerd_http_* or KV.
+
+set -e
+
+IN="$1"
+OUT="${2:-$1}"
+ASYNC_IMPORTS="env.js_http_fetch,env.js_kv_get,env.js_load_posts"
+
+wasm-opt -O2 --enable-simd --enable-bulk-memory --asyncify \
+    --pass-arg=asyncify-imports@${ASYNC_IMPORTS} \
+    "$IN" -o "$OUT"
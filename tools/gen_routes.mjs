@@ -0,0 +1,138 @@
+#!/usr/bin/env node
+/**
+ * gen_routes.mjs - Compile routes.json into the runtime's byte-trie router
+ *
+ * Usage: node tools/gen_routes.mjs [routes.json]
+ * Writes routes_gen.h (trie tables for runtime_wasm.c) and src/routes_gen.js
+ * (route ids for worker.js). A path may end in one `:param` segment, which
+ * captures the rest of the path. Matching prefers an exact route over a
+ * `:param` route, the longest prefix among `:param` routes, and declaration
+ * order among routes on the same path.
+ */
+
+import { readFileSync, writeFileSync } from "node:fs";
+import { dirname, join } from "node:path";
+import { fileURLToPath } from "node:url";
+
+const root = join(dirname(fileURLToPath(import.meta.url)), "..");
+const source = process.argv[2] || join(root, "routes.json");
+const table = JSON.parse(readFileSync(source, "utf8"));
+
+const routes = [{ id: "NONE", render: table.not_found }, ...table.routes];
+const methods = ["ANY"];
+const ids = new Set();
+
+// Node 0 is the root; every node lists its edges and the routes ending there
+const nodes = [{ edges: new Map(), exact: [], param: [] }];
+
+routes.forEach((route, index) => {
+  if (index === 0) return;
+  if (ids.has(route.id)) throw new Error(`duplicate route id ${route.id}`);
+  ids.add(route.id);
+
+  const method = route.method || "ANY";
+  if (!methods.includes(method)) methods.push(method);
+
+  const colon = route.path.indexOf(":");
+  if (colon >= 0 && (route.path[colon - 1] !== "/" || route.path.indexOf("/", colon) >= 0)) {
+    throw new Error(`${route.id}: a :param must be the last path segment`);
+  }
+  const prefix = colon >= 0 ? route.path.slice(0, colon) : route.path;
+
+  let node = 0;
+  for (const byte of Buffer.from(prefix, "utf8")) {
+    if (!nodes[node].edges.has(byte)) {
+      nodes[node].edges.set(byte, nodes.length);
+      nodes.push({ edges: new Map(), exact: [], param: [] });
+    }
+    node = nodes[node].edges.get(byte);
+  }
+  nodes[node][colon >= 0 ? "param" : "exact"].push(index);
+});
+
+if (routes.length > 256 || nodes.length > 65535) throw new Error("route table too large");
+
+// Flatten into parallel arrays the C side indexes with (start, count) pairs
+const edgeBytes = [];
+const edgeNext = [];
+const refs = [];
+const rows = nodes.map((node) => {
+  const edges = [...node.edges].sort((a, b) => a[0] - b[0]);
+  const row = [edgeBytes.length, edges.length, refs.length, node.exact.length];
+  for (const [byte, next] of edges) {
+    edgeBytes.push(byte);
+    edgeNext.push(next);
+  }
+  refs.push(...node.exact);
+  row.push(refs.length, node.param.length);
+  refs.push(...node.param);
+  return row;
+});
+
+const renders = [...new Set(routes.map((r) => r.render).filter(Boolean))];
+const list = (values, perLine = 16) => {
+  const lines = [];
+  for (let i = 0; i < values.length; i += perLine) lines.push("    " + values.slice(i, i + perLine).join(", ") + ",");
+  return lines.join("\n");
+};
+
+const header = `// routes_gen.h - generated by tools/gen_routes.mjs from routes.json. Do not edit.
+
+enum route_id {
+${routes.map((r) => `    ROUTE_${r.id},`).join("\n")}
+    ROUTE_COUNT
+};
+
+enum route_method {
+${methods.map((m) => `    ROUTE_METHOD_${m},`).join("\n")}
+    ROUTE_METHOD_COUNT
+};
+
+static const char* const route_method_names[ROUTE_METHOD_COUNT] = {
+${methods.map((m) => (m === "ANY" ? "    0," : `    "${m}",`)).join("\n")}
+};
+
+static const unsigned char route_methods[ROUTE_COUNT] = {
+${routes.map((r) => `    ROUTE_METHOD_${r.method || "ANY"},`).join("\n")}
+};
+
+// Renderers that need no host data; weak, so a NERD program may omit any of them
+${renders.map((name) => `__attribute__((weak)) extern double ${name}(void);`).join("\n")}
+
+static double (* const route_renders[ROUTE_COUNT])(void) = {
+${routes.map((r) => `    ${r.render || "0"},`).join("\n")}
+};
+
+typedef struct route_trie_node {
+    unsigned short edge_start, edge_count;    // route_trie_edge_byte/_next
+    unsigned short exact_start, exact_count;  // route_trie_refs: path ends here
+    unsigned short param_start, param_count;  // route_trie_refs: :param starts here
+} route_trie_node;
+
+static const route_trie_node route_trie_nodes[${rows.length}] = {
+${rows.map((row) => `    { ${row.join(", ")} },`).join("\n")}
+};
+
+static const unsigned char route_trie_edge_byte[${edgeBytes.length}] = {
+${list(edgeBytes.map((b) => (b >= 0x20 && b < 0x7f && b !== 0x27 && b !== 0x5c ? `'${String.fromCharCode(b)}'` : String(b))))}
+};
+
+static const unsigned short route_trie_edge_next[${edgeNext.length}] = {
+${list(edgeNext)}
+};
+
+static const unsigned char route_trie_refs[${refs.length}] = {
+${list(refs.map((i) => `ROUTE_${routes[i].id}`), 4)}
+};
+`;
+
+const module = `// routes_gen.js - generated by tools/gen_routes.mjs from routes.json. Do not edit.
+
+export const ROUTE = Object.freeze({
+${routes.map((r, i) => `  ${r.id}: ${i},`).join("\n")}
+});
+`;
+
+writeFileSync(join(root, "routes_gen.h"), header);
+writeFileSync(join(root, "src", "routes_gen.js"), module);
+console.log(`routes: ${routes.length - 1} routes, ${nodes.length} trie nodes`);
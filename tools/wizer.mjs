@@ -0,0 +1,262 @@
+#!/usr/bin/env node
+/**
+ * wizer.mjs - Pre-initialize a Wasm module and snapshot its memory
+ *
+ * Usage: node tools/wizer.mjs <module.wasm> [-o out.wasm] [--init-func wasm_init]
+ * Instantiates the module with imports that refuse to be called, runs the
+ * init export once, then rewrites the module so it starts from the resulting
+ * state: the data section becomes the non-zero ranges of linear memory, the
+ * initial memory size covers whatever init grew, and the init export (plus
+ * any start function) is removed. Rewrites the input in place by default.
+ *
+ * Only linear memory is captured. That covers C statics and the heap; the
+ * shadow stack pointer is back at its initial value once init returns, and
+ * the stack area itself is cleared from the snapshot.
+ */
+
+import { readFileSync, writeFileSync } from "node:fs";
+
+const args = process.argv.slice(2);
+let input = null;
+let output = null;
+let initFunc = "wasm_init";
+for (let i = 0; i < args.length; i++) {
+  if (args[i] === "-o") output = args[++i];
+  else if (args[i] === "--init-func") initFunc = args[++i];
+  else input = args[i];
+}
+if (!input) {
+  console.error("usage: node tools/wizer.mjs <module.wasm> [-o out.wasm] [--init-func wasm_init]");
+  process.exit(1);
+}
+output = output || input;
+
+const SECTION = { MEMORY: 5, EXPORT: 7, START: 8, CODE: 10, DATA: 11, DATA_COUNT: 12 };
+const PAGE_SIZE = 65536;
+// Zero runs shorter than this stay inside a segment: a new segment costs
+// about as many bytes (flags, offset expression, length) as it saves
+const SEGMENT_GAP = 32;
+
+// ----------------------------------------------------------------------------
+// Binary reading and writing
+// ----------------------------------------------------------------------------
+
+class Reader {
+  constructor(bytes, pos = 0) {
+    this.bytes = bytes;
+    this.pos = pos;
+  }
+  byte() {
+    return this.bytes[this.pos++];
+  }
+  u32() {
+    let result = 0, shift = 0, b;
+    do {
+      b = this.byte();
+      result += (b & 0x7f) * 2 ** shift;
+      shift += 7;
+    } while (b & 0x80);
+    return result;
+  }
+  take(len) {
+    const slice = this.bytes.subarray(this.pos, this.pos + len);
+    this.pos += len;
+    return slice;
+  }
+  name() {
+    return new TextDecoder().decode(this.take(this.u32()));
+  }
+}
+
+function u32(n) {
+  const out = [];
+  do {
+    let b = n & 0x7f;
+    n = Math.floor(n / 128);
+    if (n) b |= 0x80;
+    out.push(b);
+  } while (n);
+  return out;
+}
+
+function i32(n) {
+  const out = [];
+  for (;;) {
+    const b = n & 0x7f;
+    n >>= 7;
+    if ((n === 0 && !(b & 0x40)) || (n === -1 && (b & 0x40))) {
+      out.push(b);
+      return out;
+    }
+    out.push(b | 0x80);
+  }
+}
+
+function concat(parts) {
+  const total = parts.reduce((sum, part) => sum + part.length, 0);
+  const out = new Uint8Array(total);
+  let offset = 0;
+  for (const part of parts) {
+    out.set(part, offset);
+    offset += part.length;
+  }
+  return out;
+}
+
+function section(id, body) {
+  return concat([Uint8Array.from([id, ...u32(body.length)]), body]);
+}
+
+function parseSections(bytes) {
+  const r = new Reader(bytes, 8);
+  const sections = [];
+  while (r.pos < bytes.length) {
+    const id = r.byte();
+    const size = r.u32();
+    sections.push({ id, body: r.take(size) });
+  }
+  return sections;
+}
+
+// ----------------------------------------------------------------------------
+// Run init
+// ----------------------------------------------------------------------------
+
+const original = readFileSync(input);
+const module = new WebAssembly.Module(original);
+
+// Init must be self-contained: any host call would bake one request's
+// answer into every instance
+const imports = {};
+for (const { module: ns, name, kind } of WebAssembly.Module.imports(module)) {
+  if (kind !== "function") throw new Error(`cannot pre-initialize with imported ${kind} ${ns}.${name}`);
+  imports[ns] = imports[ns] || {};
+  imports[ns][name] = () => {
+    throw new Error(`${initFunc} called import ${ns}.${name} during pre-initialization`);
+  };
+}
+
+const instance = new WebAssembly.Instance(module, imports);
+if (typeof instance.exports[initFunc] !== "function") throw new Error(`no exported function ${initFunc}`);
+if (!(instance.exports.memory instanceof WebAssembly.Memory)) throw new Error("module does not export its memory");
+instance.exports[initFunc]();
+
+const memory = new Uint8Array(instance.exports.memory.buffer).slice();
+const pages = memory.length / PAGE_SIZE;
+
+// The shadow stack holds whatever init's frames left behind
+const { __stack_low: stackLow, __stack_high: stackHigh } = instance.exports;
+if (stackLow instanceof WebAssembly.Global && stackHigh instanceof WebAssembly.Global) {
+  memory.fill(0, stackLow.value, stackHigh.value);
+}
+
+// ----------------------------------------------------------------------------
+// Rewrite the module
+// ----------------------------------------------------------------------------
+
+function snapshotSegments() {
+  const segments = [];
+  let i = 0;
+  while (i < memory.length) {
+    while (i < memory.length && memory[i] === 0) i++;
+    if (i === memory.length) break;
+    const start = i;
+    let end = i;
+    while (i < memory.length) {
+      if (memory[i] !== 0) {
+        end = ++i;
+        continue;
+      }
+      let zeros = 0;
+      while (i < memory.length && memory[i] === 0 && zeros < SEGMENT_GAP) {
+        i++;
+        zeros++;
+      }
+      if (zeros === SEGMENT_GAP || i === memory.length) break;
+    }
+    segments.push({ start, end });
+  }
+  return segments;
+}
+
+function dataSection(segments) {
+  const parts = [Uint8Array.from(u32(segments.length))];
+  for (const { start, end } of segments) {
+    // Active segment for memory 0 at (i32.const start)
+    parts.push(Uint8Array.from([0x00, 0x41, ...i32(start), 0x0b, ...u32(end - start)]));
+    parts.push(memory.subarray(start, end));
+  }
+  return concat(parts);
+}
+
+function checkDataSection(body) {
+  const r = new Reader(body);
+  const count = r.u32();
+  for (let i = 0; i < count; i++) {
+    const flags = r.u32();
+    // Passive segments are copied in by memory.init at run time, which the
+    // snapshot cannot replay
+    if (flags & 1) throw new Error("passive data segments cannot be snapshotted");
+    if (flags & 2) r.u32();
+    // Offset expression: i32.const or global.get, then end
+    const op = r.byte();
+    if (op === 0x41) while (r.byte() & 0x80);
+    else if (op === 0x23) r.u32();
+    else throw new Error(`unsupported data segment offset (opcode 0x${op.toString(16)})`);
+    if (r.byte() !== 0x0b) throw new Error("malformed data segment offset");
+    r.take(r.u32());
+  }
+}
+
+function memorySection(body) {
+  const r = new Reader(body);
+  const count = r.u32();
+  if (count !== 1) throw new Error(`expected one memory, found ${count}`);
+  const flags = r.byte();
+  if (flags & ~1) throw new Error("shared and 64-bit memories are not supported");
+  const min = r.u32();
+  const max = flags & 1 ? r.u32() : null;
+  const initial = Math.max(min, pages);
+  return Uint8Array.from([1, flags, ...u32(initial), ...(max === null ? [] : u32(max))]);
+}
+
+function exportSection(body) {
+  const r = new Reader(body);
+  const count = r.u32();
+  const kept = [];
+  for (let i = 0; i < count; i++) {
+    const start = r.pos;
+    const name = r.name();
+    r.byte();
+    r.u32();
+    if (name !== initFunc) kept.push(body.subarray(start, r.pos));
+  }
+  return concat([Uint8Array.from(u32(kept.length)), ...kept]);
+}
+
+const segments = snapshotSegments();
+const sections = parseSections(original);
+const hasData = sections.some(({ id }) => id === SECTION.DATA);
+const parts = [original.subarray(0, 8)];
+let wroteData = false;
+for (const { id, body } of sections) {
+  if (id === SECTION.START) continue;  // already ran; its effects are in memory
+  if (id === SECTION.MEMORY) parts.push(section(id, memorySection(body)));
+  else if (id === SECTION.EXPORT) parts.push(section(id, exportSection(body)));
+  else if (id === SECTION.DATA_COUNT) parts.push(section(id, Uint8Array.from(u32(segments.length))));
+  else if (id === SECTION.DATA) checkDataSection(body);
+  else parts.push(section(id, body));
+  // Data follows the code section
+  if (id === SECTION.DATA || (id === SECTION.CODE && !hasData)) {
+    parts.push(section(SECTION.DATA, dataSection(segments)));
+    wroteData = true;
+  }
+}
+if (!wroteData) parts.push(section(SECTION.DATA, dataSection(segments)));
+
+const snapshot = concat(parts);
+new WebAssembly.Module(snapshot);  // fail the build rather than ship an invalid module
+writeFileSync(output, snapshot);
+
+const dataBytes = segments.reduce((sum, s) => sum + s.end - s.start, 0);
+console.log(`wizer: ran ${initFunc}, ${segments.length} data segments (${dataBytes} bytes), ${pages} pages -> ${output}`);